@@ -0,0 +1,262 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <CameraPath.h>
+#include <SceneManager.h>
+#include <window/Timer.h>
+
+#include <charconv>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    struct BenchOptions {
+        std::string scene;
+        std::string camera_path;
+        std::string output = "MixedEngineBench.json";
+        std::string capture;
+        std::uint32_t frames = 1000;
+        std::uint32_t warmup = 60;
+        int width = 1280;
+        int height = 720;
+        bool headless = true;
+        bool compute_post = false;
+        bool depth_prepass = false;
+    };
+
+    struct Summary {
+        double min = 0.0;
+        double avg = 0.0;
+        double median = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+        double max = 0.0;
+    };
+
+    void PrintUsage() {
+        spdlog::info("usage: MixedEngineBench <scene.xml> [--frames N] [--warmup N] [--size WxH] [--window]"
+            " [--camera path.xml] [--output report.json] [--capture frame.ppm] [--compute-post]"
+            " [--depth-prepass]");
+    }
+
+    template<typename T>
+    bool ParseNumber(const std::string_view text, T &value) {
+        const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    bool ParseOptions(const int argc, char **argv, BenchOptions &options) {
+        for (int i = 1; i < argc; i++) {
+            const std::string_view arg = argv[i];
+            const bool has_value = i + 1 < argc;
+
+            if (arg == "--window") options.headless = false;
+            else if (arg == "--compute-post") options.compute_post = true;
+            else if (arg == "--depth-prepass") options.depth_prepass = true;
+            else if (arg == "--frames" && has_value) {
+                if (!ParseNumber(argv[++i], options.frames) || options.frames == 0) return false;
+            } else if (arg == "--warmup" && has_value) {
+                if (!ParseNumber(argv[++i], options.warmup)) return false;
+            } else if (arg == "--size" && has_value) {
+                const std::string_view size = argv[++i];
+                const auto x = size.find('x');
+                if (x == std::string_view::npos) return false;
+                if (!ParseNumber(size.substr(0, x), options.width) ||
+                    !ParseNumber(size.substr(x + 1), options.height))
+                    return false;
+            } else if (arg == "--camera" && has_value) options.camera_path = argv[++i];
+            else if (arg == "--output" && has_value) options.output = argv[++i];
+            else if (arg == "--capture" && has_value) options.capture = argv[++i];
+            else if (!arg.starts_with("--") && options.scene.empty()) options.scene = arg;
+            else return false;
+        }
+        return !options.scene.empty() && options.width > 0 && options.height > 0;
+    }
+
+    Summary Summarize(std::vector<double> samples) {
+        Summary summary;
+        if (samples.empty()) return summary;
+
+        std::ranges::sort(samples);
+        const auto at = [&samples](const double fraction) {
+            const auto index = static_cast<std::size_t>(fraction * static_cast<double>(samples.size() - 1));
+            return samples[index];
+        };
+
+        double total = 0.0;
+        for (const double sample: samples) total += sample;
+
+        summary.min = samples.front();
+        summary.avg = total / static_cast<double>(samples.size());
+        summary.median = at(0.5);
+        summary.p95 = at(0.95);
+        summary.p99 = at(0.99);
+        summary.max = samples.back();
+        return summary;
+    }
+
+    void WriteSummary(std::ofstream &out, const Summary &summary) {
+        out << R"({"min":)" << summary.min << R"(,"avg":)" << summary.avg << R"(,"median":)" << summary.median
+            << R"(,"p95":)" << summary.p95 << R"(,"p99":)" << summary.p99 << R"(,"max":)" << summary.max << "}";
+    }
+
+    // Resident set size from /proc; reported as 0 where that is unavailable.
+    std::uint64_t ReadProcessMemory(const std::string &key) {
+        std::ifstream status("/proc/self/status");
+        for (std::string line; std::getline(status, line);) {
+            if (!line.starts_with(key)) continue;
+            std::uint64_t kilobytes = 0;
+            std::istringstream(line.substr(key.size() + 1)) >> kilobytes;
+            return kilobytes * 1024;
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    auto *manager = new SceneManager(RendererType::VULKAN);
+    const bool initialized = options.headless
+                                 ? manager->InitializeHeadless(options.scene, options.width, options.height)
+                                 : manager->Initialize("MixedEngineBench", options.width, options.height,
+                                                       options.scene);
+    if (!initialized) {
+        delete manager;
+        return EXIT_FAILURE;
+    }
+
+    // Measure the renderer, not the frame limiter.
+    manager->GetTimer()->SetTargetFrameRate(0.0);
+
+    CameraPath camera_path = CameraPath::Orbit(manager->GetInitialCameraView());
+    if (!options.camera_path.empty()) {
+        std::optional<CameraPath> loaded = CameraPath::Load(options.camera_path);
+        if (!loaded) {
+            delete manager;
+            return EXIT_FAILURE;
+        }
+        camera_path = std::move(*loaded);
+    }
+
+    auto *renderer = dynamic_cast<VulkanRenderer *>(manager->GetRenderer());
+    if (options.compute_post) renderer->SetComputePostProcessing(true);
+    renderer->SetDepthPrepass(options.depth_prepass);
+
+    std::vector<double> cpu_samples;
+    cpu_samples.reserve(options.frames);
+    std::array<std::vector<double>, GpuTimestamps::kScopes> gpu_samples;
+    std::array<const char *, GpuTimestamps::kScopes> gpu_names{};
+    std::uint64_t total_draw_calls = 0;
+    std::uint64_t total_triangles = 0;
+    std::uint64_t total_prepass_draw_calls = 0;
+    std::uint64_t total_shadow_views = 0;
+    std::uint64_t total_shadow_draw_calls = 0;
+    BindCounts total_binds;
+
+    spdlog::info("Benchmarking {} for {} frames ({} warmup)", options.scene, options.frames, options.warmup);
+    const std::uint32_t total_frames = options.warmup + options.frames;
+    for (std::uint32_t frame = 0; frame < total_frames; frame++) {
+        if (!options.headless) glfwPollEvents();
+
+        // Warmup frames replay the start of the path so caches see the same views.
+        const std::uint32_t path_frame = frame < options.warmup ? 0 : frame - options.warmup;
+        manager->SetCameraView(camera_path.Evaluate(static_cast<float>(path_frame) /
+                                                    static_cast<float>(options.frames)));
+
+        const auto begin = std::chrono::steady_clock::now();
+        manager->RenderFrame();
+        const auto end = std::chrono::steady_clock::now();
+
+        if (frame < options.warmup) continue;
+
+        cpu_samples.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        const std::vector<GpuScopeTiming> gpu_timings = renderer->GetGpuTimings();
+        for (std::size_t scope = 0; scope < gpu_timings.size() && scope < gpu_samples.size(); scope++) {
+            gpu_names[scope] = gpu_timings[scope].name;
+            gpu_samples[scope].push_back(gpu_timings[scope].last_ms);
+        }
+        total_draw_calls += renderer->GetRenderStats().draw_calls;
+        total_triangles += renderer->GetRenderStats().triangles;
+        total_binds += renderer->GetRenderStats().binds;
+        total_prepass_draw_calls += renderer->GetRenderStats().prepass_draw_calls;
+        total_shadow_views += renderer->GetRenderStats().shadow_views;
+        total_shadow_draw_calls += renderer->GetRenderStats().shadow_draw_calls;
+    }
+
+    if (!options.capture.empty()) {
+        if (options.headless) renderer->ReadbackFrame(options.capture);
+        else spdlog::warn("--capture needs headless mode, skipping");
+    }
+
+    std::ofstream out(options.output, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        spdlog::error("Failed to open benchmark report {}", options.output);
+        delete manager;
+        return EXIT_FAILURE;
+    }
+
+    const MemoryStats &memory = renderer->GetMemoryStats();
+    out << std::fixed << std::setprecision(4);
+    out << "{\n";
+    out << R"(  "scene": ")" << std::filesystem::path(options.scene).generic_string() << "\",\n";
+    out << R"(  "frames": )" << options.frames << ",\n";
+    out << R"(  "warmup": )" << options.warmup << ",\n";
+    out << R"(  "width": )" << options.width << ",\n";
+    out << R"(  "height": )" << options.height << ",\n";
+    out << R"(  "headless": )" << (options.headless ? "true" : "false") << ",\n";
+    out << R"(  "compute_post": )" << (options.compute_post ? "true" : "false") << ",\n";
+    out << R"(  "async_compute": )" << (renderer->UsesAsyncCompute() ? "true" : "false") << ",\n";
+    out << R"(  "dynamic_rendering": )" << (renderer->UsesDynamicRendering() ? "true" : "false") << ",\n";
+    out << R"(  "synchronization2": )" << (renderer->UsesSynchronization2() ? "true" : "false") << ",\n";
+    out << R"(  "depth_prepass": )" << (renderer->UsesDepthPrepass() ? "true" : "false") << ",\n";
+    out << R"(  "compact_vertices": )" << (renderer->GetVertexFormat() == VertexFormat::Compact ? "true" : "false")
+        << ",\n";
+    out << R"(  "bindless_textures": )" << (renderer->UsesBindlessTextures() ? "true" : "false") << ",\n";
+    out << R"(  "recording_threads": )" << renderer->GetRecordingThreadCount() << ",\n";
+    out << R"(  "lights": {"count": )" << renderer->GetLightCount()
+        << R"(, "cluster_light_indices": )" << renderer->GetClusterLightIndexCount() << "},\n";
+    out << R"(  "load_time_ms": )" << manager->GetLoadTimeMs() << ",\n";
+    out << R"(  "cpu_frame_ms": )";
+    WriteSummary(out, Summarize(cpu_samples));
+    out << ",\n";
+    out << R"(  "gpu_pass_ms": {)";
+    bool first = true;
+    for (std::size_t scope = 0; scope < gpu_samples.size(); scope++) {
+        if (gpu_names[scope] == nullptr) continue;
+        out << (first ? "\n    \"" : ",\n    \"") << gpu_names[scope] << "\": ";
+        WriteSummary(out, Summarize(gpu_samples[scope]));
+        first = false;
+    }
+    out << "\n  },\n";
+    out << R"(  "draws": {"draw_calls_per_frame": )" << total_draw_calls / options.frames
+        << R"(, "triangles_per_frame": )" << total_triangles / options.frames
+        << R"(, "prepass_draw_calls_per_frame": )" << total_prepass_draw_calls / options.frames << "},\n";
+    out << R"(  "binds_per_frame": {"pipelines": )" << total_binds.pipelines / options.frames
+        << R"(, "descriptor_sets": )" << total_binds.descriptor_sets / options.frames
+        << R"(, "vertex_buffers": )" << total_binds.vertex_buffers / options.frames
+        << R"(, "index_buffers": )" << total_binds.index_buffers / options.frames
+        << R"(, "push_constants": )" << total_binds.push_constants / options.frames << "},\n";
+    // Totals rather than per-frame rates: cached shadow maps are only redrawn now and then.
+    out << R"(  "shadows": {"views_rendered": )" << total_shadow_views
+        << R"(, "draw_calls": )" << total_shadow_draw_calls << "},\n";
+    const auto [cache_before, cache_after] = ObjectComponent::GetVertexCacheStats();
+    out << R"(  "vertex_cache": {"acmr_before": )" << cache_before.GetAcmr()
+        << R"(, "acmr_after": )" << cache_after.GetAcmr() << "},\n";
+    out << R"(  "memory": {"device_bytes": )" << memory.allocated_bytes
+        << R"(, "device_peak_bytes": )" << memory.peak_bytes
+        << R"(, "device_allocations": )" << memory.allocation_count
+        << R"(, "rss_bytes": )" << ReadProcessMemory("VmRSS:")
+        << R"(, "peak_rss_bytes": )" << ReadProcessMemory("VmHWM:") << "}\n";
+    out << "}\n";
+    out.close();
+
+    spdlog::info("Wrote benchmark report to {}", options.output);
+    delete manager;
+    return EXIT_SUCCESS;
+}
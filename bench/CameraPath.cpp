@@ -0,0 +1,85 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <CameraPath.h>
+
+#include <rapidxml-1.13/rapidxml.hpp>
+#include <rapidxml-1.13/rapidxml_utils.hpp>
+
+namespace {
+    glm::vec3 ReadVector(const rapidxml::xml_node<> *node) {
+        return {
+            std::stof(node->first_attribute("x")->value()),
+            std::stof(node->first_attribute("y")->value()),
+            std::stof(node->first_attribute("z")->value())
+        };
+    }
+}
+
+CameraPath CameraPath::Orbit(const CameraView &view, const std::uint32_t key_count) {
+    CameraPath path;
+
+    const glm::vec3 axis = glm::normalize(view.up);
+    const glm::vec3 offset = view.eye - view.center;
+    for (std::uint32_t i = 0; i <= key_count; i++) {
+        const float time = static_cast<float>(i) / static_cast<float>(key_count);
+        const glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), time * glm::two_pi<float>(), axis);
+        const glm::vec3 eye = view.center + glm::vec3(rotation * glm::vec4(offset, 0.0f));
+        path.keyframes.push_back({time, {eye, view.center, view.up}});
+    }
+
+    return path;
+}
+
+std::optional<CameraPath> CameraPath::Load(const std::string &path) {
+    if (!std::filesystem::exists(path)) {
+        spdlog::error("Camera path {} does not exist", path);
+        return std::nullopt;
+    }
+
+    rapidxml::file xmlFile(path.c_str());
+    rapidxml::xml_document doc;
+    doc.parse<0>(xmlFile.data());
+
+    CameraPath camera_path;
+    const auto *base_node = doc.first_node("CameraPath");
+    if (base_node == nullptr) {
+        spdlog::error("{} has no <CameraPath> root", path);
+        return std::nullopt;
+    }
+
+    for (const auto *node = base_node->first_node("Key"); node; node = node->next_sibling("Key")) {
+        CameraKeyframe keyframe;
+        keyframe.time = std::stof(node->first_attribute("t")->value());
+        keyframe.view.eye = ReadVector(node->first_node("Eye"));
+        keyframe.view.center = ReadVector(node->first_node("Center"));
+        keyframe.view.up = ReadVector(node->first_node("Up"));
+        camera_path.keyframes.push_back(keyframe);
+    }
+
+    if (camera_path.keyframes.empty()) {
+        spdlog::error("{} has no camera keys", path);
+        return std::nullopt;
+    }
+
+    std::ranges::sort(camera_path.keyframes, {}, &CameraKeyframe::time);
+    return camera_path;
+}
+
+CameraView CameraPath::Evaluate(const float time) const {
+    if (keyframes.empty()) return {};
+    if (time <= keyframes.front().time) return keyframes.front().view;
+    if (time >= keyframes.back().time) return keyframes.back().view;
+
+    const auto next = std::ranges::upper_bound(keyframes, time, {}, &CameraKeyframe::time);
+    const auto previous = next - 1;
+    const float span = next->time - previous->time;
+    const float blend = span > 0.0f ? (time - previous->time) / span : 0.0f;
+
+    return {
+        glm::mix(previous->view.eye, next->view.eye, blend),
+        glm::mix(previous->view.center, next->view.center, blend),
+        glm::normalize(glm::mix(previous->view.up, next->view.up, blend))
+    };
+}
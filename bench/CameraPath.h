@@ -0,0 +1,28 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <SceneManager.h>
+
+struct CameraKeyframe {
+    float time = 0.0f; /// Normalized position along the path, 0..1.
+    CameraView view;
+};
+
+/// Camera keyframes played back by frame index, never by wall-clock time, so
+/// every run of a benchmark renders exactly the same views.
+class CameraPath {
+public:
+    /// One revolution around view.center at the distance of view.eye.
+    static CameraPath Orbit(const CameraView &view, std::uint32_t key_count = 64);
+    /// Reads <CameraPath><Key t=".."><Eye/><Center/><Up/></Key>...</CameraPath>.
+    static std::optional<CameraPath> Load(const std::string &path);
+
+    [[nodiscard]] CameraView Evaluate(float time) const;
+    [[nodiscard]] bool Empty() const { return keyframes.empty(); }
+
+private:
+    std::vector<CameraKeyframe> keyframes;
+};
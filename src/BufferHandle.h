@@ -7,4 +7,6 @@
 struct BufferHandle {
     VkBuffer buffer = VK_NULL_HANDLE;
     VkDeviceMemory memory = VK_NULL_HANDLE;
+    /// How an index buffer is bound; CreateIndexBuffer narrows it when it can.
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
 };
\ No newline at end of file
@@ -0,0 +1,15 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <Collider.h>
+
+bool Collider::OnCreate() {
+    return true;
+}
+
+void Collider::OnDestroy() {}
+
+void Collider::Update(float deltaTime) {}
+
+void Collider::Render() const {}
@@ -3,50 +3,145 @@
 //
 
 #include <Debug.h>
+
+#include <thread>
+
 std::string Debug::fileName = "";
+std::atomic<Debug::LogNode*> Debug::head{nullptr};
+Debug::LogNode* Debug::tail = nullptr;
+std::atomic<bool> Debug::running{false};
+std::atomic<std::uint32_t> Debug::producers{0};
+std::atomic<std::uint64_t> Debug::enqueued{0};
+std::atomic<std::uint64_t> Debug::written{0};
+
+namespace {
+    std::thread writerThread;
+}
 
 void Debug::DebugInit(const std::string& fileName_) {
+    if (running.load(std::memory_order_acquire)) {
+        DebugShutdown();
+    }
+
     fileName = fileName_ + ".txt";
     std::ofstream out;
     out.open(fileName, std::ios::out);
     out << "";
     out.close();
+
+    auto* stub = new LogNode();
+    tail = stub;
+    head.store(stub, std::memory_order_release);
+    running.store(true, std::memory_order_release);
+    writerThread = std::thread(&Debug::WriterLoop);
 }
 
-void Debug::Log(const MessageType type_, const std::string& message_, const std::string& fileName_, const int line_) {
-    std::ofstream out;
-    std::string msg;
-    out.open(fileName, std::ios::out | std::ios::app);
-    if (type_ == TYPE_INFO) {
-        msg = message_;
+void Debug::DebugShutdown() {
+    // Sequentially consistent with the producers' increment and check in Log:
+    // any Log that saw running is counted by the time the loop below reads.
+    if (!running.exchange(false)) return;
+    while (producers.load() != 0) {
+        std::this_thread::yield();
     }
-    else {
-        msg = message_ + " in file: " + fileName_ + " on line: " + std::to_string(line_);
+    if (writerThread.joinable()) writerThread.join();
+
+    // The writer's last pass may have run before the final producers linked
+    // their nodes.
+    std::string batch;
+    if (Drain(batch)) {
+        std::ofstream out(fileName, std::ios::out | std::ios::app);
+        WriteBatch(out, batch);
     }
-#ifdef _DEBUG
-    std::cout << msg << std::endl;
-#endif
-    out << msg << std::endl;
-    out.flush();
-    out.close();
+
+    delete tail;
+    tail = nullptr;
+    head.store(nullptr, std::memory_order_release);
 }
 
-void Debug::Info(const std::string& message_, const std::string& fileName_, const int line_) {
-    Log(MessageType::TYPE_INFO, "[INFO]: " + message_, fileName_, line_);
+void Debug::Flush() {
+    const std::uint64_t target = enqueued.load(std::memory_order_acquire);
+    while (running.load(std::memory_order_acquire) && written.load(std::memory_order_acquire) < target) {
+        std::this_thread::yield();
+    }
 }
 
-void Debug::Trace(const std::string& message_, const std::string& fileName_, const int line_) {
-    Log(MessageType::TYPE_TRACE, "[TRACE]: " + message_, fileName_, line_);
+void Debug::Log(const MessageType type_, std::string message_, const char* fileName_, const int line_) {
+    producers.fetch_add(1);
+    if (!running.load()) {
+        producers.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    auto* node = new LogNode();
+    node->type = type_;
+    node->message = std::move(message_);
+    node->file = fileName_;
+    node->line = line_;
+
+    LogNode* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+    enqueued.fetch_add(1, std::memory_order_release);
+    producers.fetch_sub(1, std::memory_order_release);
 }
 
-void Debug::Warning(const std::string& message_, const std::string& fileName_, const int line_) {
-    Log(MessageType::TYPE_WARNING, "[WARNING]: " + message_, fileName_, line_);
+void Debug::Format(const LogNode& node, std::string& out) {
+    switch (node.type) {
+        case TYPE_INFO: out += "[INFO]: "; break;
+        case TYPE_TRACE: out += "[TRACE]: "; break;
+        case TYPE_WARNING: out += "[WARNING]: "; break;
+        case TYPE_ERROR: out += "[ERROR]: "; break;
+        case TYPE_FATAL_ERROR: out += "[FATAL ERROR]: "; break;
+        default: break;
+    }
+    out += node.message;
+    if (node.type != TYPE_INFO) {
+        out += " in file: ";
+        out += node.file != nullptr ? node.file : "";
+        out += " on line: ";
+        out += std::to_string(node.line);
+    }
+    out += '\n';
 }
 
-void Debug::Error(const std::string& message_, const std::string& fileName_, const int line_) {
-    Log(MessageType::TYPE_ERROR, "[ERROR]: " + message_, fileName_, line_);
+bool Debug::Drain(std::string& batch) {
+    bool any = false;
+    for (LogNode* next = tail->next.load(std::memory_order_acquire); next != nullptr;
+         next = tail->next.load(std::memory_order_acquire)) {
+        Format(*next, batch);
+        delete tail;
+        tail = next;
+        any = true;
+    }
+    return any;
 }
 
-void Debug::FatalError(const std::string& message_, const std::string& fileName_, const int line_) {
-    Log(MessageType::TYPE_FATAL_ERROR, "[FATAL ERROR]: " + message_, fileName_, line_);
+void Debug::WriteBatch(std::ofstream& out, std::string& batch) {
+#ifdef _DEBUG
+    std::cout << batch;
+#endif
+    out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+    out.flush();
+    batch.clear();
+}
+
+void Debug::WriterLoop() {
+    std::ofstream out(fileName, std::ios::out | std::ios::app);
+    std::string batch;
+    batch.reserve(64 * 1024);
+
+    while (true) {
+        const bool stopping = !running.load(std::memory_order_acquire);
+        const std::uint64_t target = enqueued.load(std::memory_order_acquire);
+
+        if (Drain(batch)) WriteBatch(out, batch);
+
+        // Nodes are counted only once linked, so an empty queue after the
+        // drain means everything counted before it has been written.
+        if (tail->next.load(std::memory_order_acquire) == nullptr) {
+            written.store(target, std::memory_order_release);
+        }
+
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
 }
@@ -5,6 +5,12 @@
 #ifndef DEBUG_H
 #define DEBUG_H
 
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
 enum MessageType : unsigned short {
     TYPE_NONE = 0,
     TYPE_FATAL_ERROR,
@@ -14,6 +20,18 @@ enum MessageType : unsigned short {
     TYPE_INFO
 };
 
+/// Most verbose message type that is compiled in. Calls above this level
+/// compile to nothing past evaluating their arguments: the message is taken
+/// as a view and only copied once the level is enabled, so literals are free,
+/// but a message concatenated at the call site is still built.
+#ifndef DEBUG_LOG_LEVEL
+#ifdef NDEBUG
+#define DEBUG_LOG_LEVEL TYPE_WARNING
+#else
+#define DEBUG_LOG_LEVEL TYPE_INFO
+#endif
+#endif
+
 class Debug {
 public:
     Debug(const Debug&) = delete;
@@ -23,23 +41,57 @@ public:
 
     Debug() = delete;
 
+    /// Truncates the log file and starts the background writer. Messages
+    /// logged before this are dropped.
     static void DebugInit(const std::string& fileName_);
-    static void Info(const std::string& message_,
-        const std::string& fileName_, int line_);
-    static void Trace(const std::string& message_,
-        const std::string& fileName_, int line_);
-    static void Warning(const std::string& message_,
-        const std::string& fileName_, int line_);
-    static void Error(const std::string& message_,
-        const std::string& fileName_, int line_);
-    static void FatalError(const std::string& message_,
-        const std::string& fileName_, int line_);
+    /// Drains pending messages and stops the writer thread.
+    static void DebugShutdown();
+    /// Blocks until every message logged so far has reached the file.
+    static void Flush();
+
+    static void Info(std::string_view message_, const char* fileName_, int line_) {
+        if constexpr (TYPE_INFO <= DEBUG_LOG_LEVEL) Log(TYPE_INFO, std::string(message_), fileName_, line_);
+    }
+    static void Trace(std::string_view message_, const char* fileName_, int line_) {
+        if constexpr (TYPE_TRACE <= DEBUG_LOG_LEVEL) Log(TYPE_TRACE, std::string(message_), fileName_, line_);
+    }
+    static void Warning(std::string_view message_, const char* fileName_, int line_) {
+        if constexpr (TYPE_WARNING <= DEBUG_LOG_LEVEL) Log(TYPE_WARNING, std::string(message_), fileName_, line_);
+    }
+    static void Error(std::string_view message_, const char* fileName_, int line_) {
+        if constexpr (TYPE_ERROR <= DEBUG_LOG_LEVEL) Log(TYPE_ERROR, std::string(message_), fileName_, line_);
+    }
+    static void FatalError(std::string_view message_, const char* fileName_, int line_) {
+        Log(TYPE_FATAL_ERROR, std::string(message_), fileName_, line_);
+        Flush();
+    }
+
 private:
-    static void Log(MessageType type_,
-        const std::string& message_,
-        const std::string& fileName_,
-        int line_);
+    // Node of the intrusive MPSC queue (Vyukov). Producers only exchange the
+    // head pointer; the writer thread is the single consumer walking the tail.
+    struct LogNode {
+        std::atomic<LogNode*> next{nullptr};
+        MessageType type = TYPE_NONE;
+        std::string message;
+        const char* file = nullptr;
+        int line = 0;
+    };
+
+    static void Log(MessageType type_, std::string message_, const char* fileName_, int line_);
+    static void WriterLoop();
+    static bool Drain(std::string& batch);
+    static void WriteBatch(std::ofstream& out, std::string& batch);
+    static void Format(const LogNode& node, std::string& out);
+
     static std::string fileName;
+    static std::atomic<LogNode*> head;
+    static LogNode* tail;
+    static std::atomic<bool> running;
+    // Log calls between their running check and linking their node. Shutdown
+    // waits for none to be left before it drains and frees the queue.
+    static std::atomic<std::uint32_t> producers;
+    static std::atomic<std::uint64_t> enqueued;
+    static std::atomic<std::uint64_t> written;
 };
 
-#endif // !DEBUG_H
\ No newline at end of file
+#endif // !DEBUG_H
@@ -5,11 +5,21 @@
 #pragma once
 
 struct LightUBO {
-    glm::vec4 position{};
+    glm::vec4 position{}; // w: range, where the light fades to nothing
+    glm::vec4 diffuse{};  // w: shadow map slot or -1, assigned by the renderer
+};
+
+struct DirectionalLight {
+    glm::vec4 direction{}; // xyz: where the light travels, w: 1 when the scene has one
     glm::vec4 diffuse{};
 };
 
+// Range of lights whose scene does not give one.
+constexpr float kDefaultLightRange = 30.0f;
+
 struct GlobalLighting {
-    LightUBO lights[10];
-    int numLights = 0;
-};
\ No newline at end of file
+    std::vector<LightUBO> lights;
+    /// Indices into lights of those casting shadows. Only the first few get a shadow map.
+    std::vector<std::uint32_t> shadow_casters;
+    DirectionalLight sun;
+};
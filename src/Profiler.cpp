@@ -0,0 +1,127 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <Profiler.h>
+
+#if MIXED_ENGINE_PROFILING
+
+#include <atomic>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+
+namespace {
+    constexpr std::size_t kEventsPerThread = 1 << 16;
+
+    // One ring per thread. Only the owning thread writes events; the exporter
+    // reads up to the published write index, so recording never takes a lock.
+    struct ThreadBuffer {
+        std::unique_ptr<ProfileEvent[]> events = std::make_unique<ProfileEvent[]>(kEventsPerThread);
+        std::atomic<std::uint64_t> write_index{0};
+        std::uint32_t thread_id = 0;
+        std::string thread_name;
+        std::uint32_t depth = 0;
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+        const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    };
+
+    Registry &GetRegistry() {
+        static Registry registry;
+        return registry;
+    }
+
+    // Buffers are owned by the registry rather than the thread so zones
+    // recorded by short-lived workers survive until export.
+    ThreadBuffer &GetThreadBuffer() {
+        thread_local ThreadBuffer *buffer = nullptr;
+        if (buffer == nullptr) {
+            Registry &registry = GetRegistry();
+            std::lock_guard lock(registry.mutex);
+            auto owned = std::make_unique<ThreadBuffer>();
+            owned->thread_id = static_cast<std::uint32_t>(registry.buffers.size());
+            owned->thread_name = owned->thread_id == 0 ? "Main" : "Worker " + std::to_string(owned->thread_id);
+            buffer = owned.get();
+            registry.buffers.push_back(std::move(owned));
+        }
+        return *buffer;
+    }
+
+    void WriteJsonString(std::ofstream &out, const char *text) {
+        out << '"';
+        for (const char *c = text; *c != '\0'; ++c) {
+            if (*c == '"' || *c == '\\') out << '\\';
+            out << *c;
+        }
+        out << '"';
+    }
+}
+
+std::uint64_t Profiler::Now() {
+    const auto elapsed = std::chrono::steady_clock::now() - GetRegistry().epoch;
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+void Profiler::SetThreadName(const std::string &name) {
+    ThreadBuffer &buffer = GetThreadBuffer();
+    std::lock_guard lock(GetRegistry().mutex);
+    buffer.thread_name = name;
+}
+
+std::uint32_t Profiler::PushZone() {
+    return GetThreadBuffer().depth++;
+}
+
+void Profiler::PopZone(const char *name, const std::uint64_t begin_ns, const std::uint32_t depth) {
+    const std::uint64_t end_ns = Now();
+    ThreadBuffer &buffer = GetThreadBuffer();
+    buffer.depth = depth;
+
+    const std::uint64_t index = buffer.write_index.load(std::memory_order_relaxed);
+    buffer.events[index % kEventsPerThread] = {name, begin_ns, end_ns, depth};
+    buffer.write_index.store(index + 1, std::memory_order_release);
+}
+
+bool Profiler::WriteChromeTrace(const std::string &path) {
+    std::ofstream out(path, std::ios::out | std::ios::trunc);
+    if (!out.is_open()) {
+        spdlog::error("Failed to open profiler trace file {}", path);
+        return false;
+    }
+
+    Registry &registry = GetRegistry();
+    std::lock_guard lock(registry.mutex);
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for (const auto &buffer: registry.buffers) {
+        if (!first) out << ',';
+        first = false;
+        out << R"({"name":"thread_name","ph":"M","pid":1,"tid":)" << buffer->thread_id << R"(,"args":{"name":)";
+        WriteJsonString(out, buffer->thread_name.c_str());
+        out << "}}";
+
+        const std::uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+        const std::uint64_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const ProfileEvent &event = buffer->events[i % kEventsPerThread];
+            out << R"(,{"name":)";
+            WriteJsonString(out, event.name);
+            out << R"(,"ph":"X","pid":1,"tid":)" << buffer->thread_id
+                << R"(,"ts":)" << static_cast<double>(event.begin_ns) / 1000.0
+                << R"(,"dur":)" << static_cast<double>(event.end_ns - event.begin_ns) / 1000.0
+                << R"(,"args":{"depth":)" << event.depth << "}}";
+        }
+    }
+    out << "]}\n";
+
+    spdlog::info("Wrote profiler trace to {}", path);
+    return true;
+}
+
+#endif
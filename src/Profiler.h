@@ -0,0 +1,74 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// The profiler is always built into non-release builds; release builds only
+// get it when configured with -DMIXED_ENGINE_PROFILER=ON. Otherwise every
+// PROFILE_* macro expands to nothing and no profiler symbol is referenced.
+#if defined(MIXED_ENGINE_PROFILER) || !defined(NDEBUG)
+#define MIXED_ENGINE_PROFILING 1
+#else
+#define MIXED_ENGINE_PROFILING 0
+#endif
+
+struct ProfileEvent {
+    const char *name;
+    std::uint64_t begin_ns;
+    std::uint64_t end_ns;
+    std::uint32_t depth;
+};
+
+class Profiler {
+public:
+    Profiler() = delete;
+
+    /// Monotonic nanoseconds since the profiler was first touched.
+    static std::uint64_t Now();
+
+    /// Names the calling thread in exported traces.
+    static void SetThreadName(const std::string &name);
+
+    static std::uint32_t PushZone();
+    static void PopZone(const char *name, std::uint64_t begin_ns, std::uint32_t depth);
+
+    /// Writes every buffered zone as Chrome trace event JSON (chrome://tracing,
+    /// Perfetto, speedscope). Call it while worker threads are quiescent.
+    static bool WriteChromeTrace(const std::string &path);
+};
+
+class ProfileScope {
+public:
+    explicit ProfileScope(const char *name_) : name(name_), depth(0), begin(0) {
+        depth = Profiler::PushZone();
+        begin = Profiler::Now();
+    }
+
+    ~ProfileScope() {
+        Profiler::PopZone(name, begin, depth);
+    }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+    const char *name;
+    std::uint32_t depth;
+    std::uint64_t begin;
+};
+
+#if MIXED_ENGINE_PROFILING
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+#define PROFILE_THREAD(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_FUNCTION() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
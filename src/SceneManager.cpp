@@ -9,66 +9,163 @@
 #include <rapidxml-1.13/rapidxml_utils.hpp>
 
 #include <Camera.h>
+#include <Collider.h>
 #include <Trackball.h>
+#include <window/Timer.h>
+#include <Debug.h>
+#include <Profiler.h>
 
 #include <components/TransformComponent.h>
 
-SceneManager::SceneManager(RendererType render_type_) : renderType(render_type_), camera(nullptr), trackball(nullptr) {}
+#include <random>
+#include <ranges>
+
+SceneManager::SceneManager(RendererType render_type_) : renderType(render_type_), window(nullptr),
+                                                        currentScene(nullptr), timer(nullptr), camera(nullptr),
+                                                        trackball(nullptr), renderer(nullptr), fps(0),
+                                                        isRunning(false) {}
 
 SceneManager::~SceneManager() {
+#if MIXED_ENGINE_PROFILING
+    Profiler::WriteChromeTrace("MixedEngineProfile.json");
+#endif
+    delete timer;
     delete trackball;
     delete camera;
     delete currentScene;
     delete window;
     delete renderer;
+    Debug::DebugShutdown();
 }
 
 void SceneManager::Run() {
-    while (!glfwWindowShouldClose(window->getGLFWwindow())) {
+    timer->Start();
+    isRunning = true;
+    while (isRunning && !glfwWindowShouldClose(window->getGLFWwindow())) {
+        PROFILE_SCOPE("Frame");
+        timer->UpdateFrameTicks();
         glfwPollEvents();
         if (trackball) {
             trackball->HandleEvents(); // Handle trackball events
         }
         if (renderType == RendererType::VULKAN) {
             VulkanRenderer *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
-            for (auto key: vRenderer->shaders_)
-                if (glfwGetKey(window->getGLFWwindow(), key.first) == GLFW_PRESS)
-                    vRenderer->HandleShaderSwitch(key.first);
-            if (vRenderer->BeginFrame()) {
-                currentScene->Render();
-                vRenderer->EndFrame();
-            };
+            // Switch on the press edge only; holding a key must not re-trigger.
+            for (const auto &key: vRenderer->post_chains_ | std::views::keys) {
+                const bool pressed = glfwGetKey(window->getGLFWwindow(), key) == GLFW_PRESS;
+                if (pressed && !keyStates[key])
+                    vRenderer->HandleShaderSwitch(key);
+                keyStates[key] = pressed;
+            }
+            const bool compute_pressed = glfwGetKey(window->getGLFWwindow(), GLFW_KEY_C) == GLFW_PRESS;
+            if (compute_pressed && !keyStates[GLFW_KEY_C])
+                vRenderer->SetComputePostProcessing(!vRenderer->IsComputePostProcessing());
+            keyStates[GLFW_KEY_C] = compute_pressed;
         }
+        if (RenderFrame())
+            timer->MarkPresent();
+        {
+            PROFILE_SCOPE("WaitForNextFrame");
+            timer->WaitForNextFrame();
+        }
+        if (++frameCount % 600 == 0)
+            ReportFrameTimings();
+    }
+    isRunning = false;
+}
+
+bool SceneManager::RenderFrame() {
+    if (renderType != RendererType::VULKAN) return false;
+
+    VulkanRenderer *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
+    if (!vRenderer->BeginFrame()) return false;
+    currentScene->Render();
+    vRenderer->EndFrame();
+    return true;
+}
+
+void SceneManager::SetCameraView(const CameraView &view_) {
+    if (trackball) trackball->SetInitialView(view_.eye, view_.center, view_.up);
+    else camera->LookAt(view_.eye, view_.center, view_.up);
+
+    if (renderType == RendererType::VULKAN) {
+        VulkanRenderer *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
+        vRenderer->SetViewProjection(camera->GetViewMatrix(), camera->GetProjectionMatrix(), view_.eye);
     }
 }
 
-bool SceneManager::Initialize(const std::string &name_, const int width_, const int height_) {
+bool SceneManager::Initialize(const std::string &name_, const int width_, const int height_,
+                              const std::string &scene_) {
+    Debug::DebugInit("MixedEngineLog");
     window = new Window(name_.c_str(), width_, height_, false);
     renderer = new VulkanRenderer(window);
+
+    // Pace to the display refresh rate; 0 (unknown refresh) leaves the limiter off.
+    fps = static_cast<unsigned int>(window->GetRefreshRate());
+    timer = new Timer();
+    timer->SetTargetFrameRate(fps);
+
     if (renderType == RendererType::VULKAN) {
         VulkanRenderer *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
-        vRenderer->shaders_ = {
-            {GLFW_KEY_1, "shaders/nopost.frag.spv"},
-            {GLFW_KEY_2, "shaders/grayscale.frag.spv"},
-            {GLFW_KEY_3, "shaders/colorReduction.frag.spv"},
-            {GLFW_KEY_4, "shaders/scanlines.frag.spv"},
-            {GLFW_KEY_5, "shaders/pixelation.frag.spv"},
-            {GLFW_KEY_6, "shaders/retro.frag.spv"},
-            {GLFW_KEY_7, "shaders/crt.frag.spv"},
-            {GLFW_KEY_8, "shaders/chromab.frag.spv"},
-            {GLFW_KEY_9, "shaders/vignette.frag.spv"},
-            {GLFW_KEY_0, "shaders/brightness.frag.spv"},
-            {GLFW_KEY_P, "shaders/bloom.frag.spv"},
-        };
+        // Effects are applied in order; pointwise ones fuse into the pass before them.
+        const PostEffectStep pixelation = {PostEffectType::Pixelation, glm::vec4(140.0f)};
+        const PostEffectStep colorReduction = {PostEffectType::ColorReduction, glm::vec4(5.0f)};
+        const PostEffectStep scanlines = {PostEffectType::Scanlines, {0.4f, 400.0f, 0.0f, 0.0f}};
+        const PostEffectStep vignette = {PostEffectType::Vignette, glm::vec4(0.5f)};
+        const PostEffectStep brightness = {PostEffectType::Brightness, glm::vec4(2.0f)};
+        vRenderer->RegisterPostChains({
+            {GLFW_KEY_1, {}},
+            {GLFW_KEY_2, {{PostEffectType::Grayscale}}},
+            {GLFW_KEY_3, {colorReduction}},
+            {GLFW_KEY_4, {scanlines}},
+            {GLFW_KEY_5, {pixelation}},
+            {GLFW_KEY_6, {pixelation, colorReduction, scanlines}},
+            {
+                GLFW_KEY_7, {
+                    {PostEffectType::ChromaticAberration, {0.005f, 0.1f, 0.0f, 0.0f}},
+                    {PostEffectType::Scanlines, {0.3f, 400.0f, 0.0f, 0.0f}}, vignette, brightness
+                }
+            },
+            {GLFW_KEY_8, {{PostEffectType::ChromaticAberration, {0.005f, 0.0f, 0.0f, 0.0f}}}},
+            {GLFW_KEY_9, {vignette}},
+            {GLFW_KEY_0, {brightness}},
+            {GLFW_KEY_P, {{PostEffectType::Bloom, {0.8f, 2.0f, 1.2f, 0.0f}}}},
+        });
     }
     camera = new Camera(); // Create camera
     trackball = new Trackball(window->getGLFWwindow(), camera, dynamic_cast<VulkanRenderer *>(renderer));
     // Create trackball with renderer
-    currentScene = LoadScene("./assets/scenes/Scene1.xml");
+    currentScene = LoadScene(scene_);
 
     return true;
 }
 
+bool SceneManager::InitializeHeadless(const std::string &scene_, const int width_, const int height_) {
+    Debug::DebugInit("MixedEngineLog");
+    if (renderType != RendererType::VULKAN) {
+        spdlog::error("Headless mode is only supported by the Vulkan renderer");
+        return false;
+    }
+
+    renderer = new VulkanRenderer(static_cast<std::uint32_t>(width_), static_cast<std::uint32_t>(height_));
+    timer = new Timer();
+    camera = new Camera();
+    currentScene = LoadScene(scene_);
+
+    return true;
+}
+
+void SceneManager::ReportFrameTimings() const {
+    const FrameStatistics cpu = timer->GetFrameStatistics();
+    spdlog::info("CPU frame: min {:.3f} ms, avg {:.3f} ms, p99 {:.3f} ms", cpu.min_ms, cpu.avg_ms, cpu.p99_ms);
+
+    if (renderType == RendererType::VULKAN) {
+        const auto *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
+        for (const auto &[name, last_ms, avg_ms, max_ms]: vRenderer->GetGpuTimings())
+            spdlog::info("GPU {}: avg {:.3f} ms, max {:.3f} ms", name, avg_ms, max_ms);
+    }
+}
+
 void SceneManager::GetEvents() {}
 
 void SceneManager::ChangeScene(SCENE_NUMBER scene_) {}
@@ -93,8 +190,114 @@ glm::vec4 GetVector4(rapidxml::xml_node<> *node, const std::string &namex = "x",
     };
 }
 
+std::string GetAttribute(const rapidxml::xml_node<> *node, const char *name, const std::string &fallback) {
+    const auto *attribute = node->first_attribute(name);
+    return attribute ? attribute->value() : fallback;
+}
+
+// mt19937 is specified bit for bit by the standard but the distributions are
+// not, so floats come straight from the raw output. A seed then produces the
+// same scene with every standard library.
+struct SceneRandom {
+    std::mt19937 engine;
+
+    explicit SceneRandom(const std::uint32_t seed) : engine(seed) {}
+
+    float Next() { return static_cast<float>(engine() >> 8) * (1.0f / 16777216.0f); }
+    float Range(const float min, const float max) { return min + (max - min) * Next(); }
+    glm::vec3 Range(const glm::vec3 &min, const glm::vec3 &max) {
+        return {Range(min.x, max.x), Range(min.y, max.y), Range(min.z, max.z)};
+    }
+    std::size_t Index(const std::size_t count) {
+        return std::min(static_cast<std::size_t>(Next() * static_cast<float>(count)), count - 1);
+    }
+};
+
+void GetBounds(const rapidxml::xml_node<> *node, glm::vec3 &min, glm::vec3 &max) {
+    if (const auto *bounds = node->first_node("Bounds")) {
+        min = GetVector(bounds->first_node("Min"));
+        max = GetVector(bounds->first_node("Max"));
+    }
+}
+
+// <Generate seed="1" count="N" colliders="K"> with one or more
+// <Model obj=".." basedir=".." scale=".."/> and an optional <Bounds>.
+// Spawns N actors with random models and transforms; the first K also get a
+// sphere collider around the model bounds.
+void GenerateActors(VulkanRenderer *vRenderer, const rapidxml::xml_node<> *node, Scene *scene) {
+    PROFILE_FUNCTION();
+    SceneRandom random(std::stoul(GetAttribute(node, "seed", "1")));
+    const std::size_t count = std::stoul(GetAttribute(node, "count", "0"));
+    const std::size_t colliders = std::stoul(GetAttribute(node, "colliders", "0"));
+
+    struct GeneratedModel {
+        std::string obj;
+        std::string basedir;
+        float scale;
+    };
+    std::vector<GeneratedModel> models;
+    for (const auto *model = node->first_node("Model"); model; model = model->next_sibling("Model"))
+        models.push_back({
+            model->first_attribute("obj")->value(), model->first_attribute("basedir")->value(),
+            std::stof(GetAttribute(model, "scale", "1.0"))
+        });
+    if (models.empty()) {
+        spdlog::error("<Generate> in <Actors> needs at least one <Model>");
+        return;
+    }
+
+    glm::vec3 bounds_min(-50.0f), bounds_max(50.0f);
+    GetBounds(node, bounds_min, bounds_max);
+
+    for (std::size_t i = 0; i < count; i++) {
+        const GeneratedModel &model = models[random.Index(models.size())];
+        const glm::vec3 position = random.Range(bounds_min, bounds_max);
+        const glm::quat orientation(glm::radians(random.Range(glm::vec3(0.0f), glm::vec3(360.0f))));
+        const float scale = model.scale * random.Range(0.75f, 1.25f);
+
+        auto *actor = new Actor(nullptr);
+        actor->AddComponent<ObjectComponent>(model.obj.c_str(), model.basedir.c_str(), actor, vRenderer);
+        actor->AddComponent<TransformComponent, Component *, glm::vec3, glm::quat, glm::vec3>(
+            actor, glm::vec3(position), glm::quat(orientation), glm::vec3(scale));
+
+        if (i < colliders) {
+            const ObjectAsset *asset = actor->GetComponent<ObjectComponent>()->getAsset();
+            const glm::vec3 center = position + orientation * (0.5f * (asset->bounds_min + asset->bounds_max) * scale);
+            const float radius = 0.5f * glm::length(asset->bounds_max - asset->bounds_min) * scale;
+            actor->AddComponent<Collider>(center, radius, actor);
+        }
+        scene->AddActor(actor);
+    }
+
+    spdlog::info("Generated {} actors ({} with colliders) from {} models", count, std::min(count, colliders),
+                 models.size());
+}
+
+// <Generate seed="1" count="M" range="R"> with an optional <Bounds>: M point
+// lights with random positions and colors, all reaching R units.
+void GenerateLights(const rapidxml::xml_node<> *node, std::vector<LightUBO> &lights) {
+    SceneRandom random(std::stoul(GetAttribute(node, "seed", "1")));
+    const std::size_t count = std::stoul(GetAttribute(node, "count", "0"));
+    const float range = std::stof(GetAttribute(node, "range", std::to_string(kDefaultLightRange)));
+
+    glm::vec3 bounds_min(-50.0f), bounds_max(50.0f);
+    GetBounds(node, bounds_min, bounds_max);
+
+    for (std::size_t i = 0; i < count; i++) {
+        const glm::vec3 position = random.Range(bounds_min, bounds_max);
+        const glm::vec3 color = random.Range(glm::vec3(0.2f), glm::vec3(1.0f));
+        lights.push_back({glm::vec4(position, range), glm::vec4(color, 1.0f)});
+    }
+}
+
 void LoadActors(VulkanRenderer *vRenderer, const rapidxml::xml_node<> *baseNode, Scene *scene) {
+    PROFILE_FUNCTION();
     for (const rapidxml::xml_node<> *node = baseNode->first_node(); node; node = node->next_sibling()) {
+        if (std::string(node->name()) == "Generate") {
+            GenerateActors(vRenderer, node, scene);
+            continue;
+        }
+
         auto *actor = new Actor(nullptr);
         for (const auto *node2 = node->first_node(); node2; node2 = node2->next_sibling()) {
             if (std::string(node2->name()) == "ObjectComponent")
@@ -112,6 +315,13 @@ void LoadActors(VulkanRenderer *vRenderer, const rapidxml::xml_node<> *baseNode,
 
                 actor->AddComponent<TransformComponent, Component *, glm::vec3, glm::quat, glm::vec3>(
                     actor, std::move(position), glm::quat(v_orientation), std::move(v_scale));
+            } else if (std::string(node2->name()) == "Collider") {
+                if (GetAttribute(node2, "type", "sphere") == "box")
+                    actor->AddComponent<Collider>(GetVector(node2->first_node("Max")),
+                                                  GetVector(node2->first_node("Min")), actor);
+                else
+                    actor->AddComponent<Collider>(GetVector(node2->first_node("Position")),
+                                                  std::stof(node2->first_attribute("radius")->value()), actor);
             }
         }
         scene->AddActor(actor);
@@ -119,6 +329,8 @@ void LoadActors(VulkanRenderer *vRenderer, const rapidxml::xml_node<> *baseNode,
 }
 
 Scene *SceneManager::LoadScene(const std::string &name_) {
+    PROFILE_FUNCTION();
+    const auto load_begin = std::chrono::steady_clock::now();
     rapidxml::file xmlFile(name_.c_str());
     rapidxml::xml_document doc;
     doc.parse<0>(xmlFile.data());
@@ -134,7 +346,6 @@ Scene *SceneManager::LoadScene(const std::string &name_) {
         auto skybox_node = state_node->first_node("Skybox");
         auto lights_node = baseNode->first_node("Lights");
         std::array<const char *, 6> names;
-        LightUBO lightUBOs[10];
 
         glm::vec2 size = vRenderer->GetWindowSize();
         glm::vec3 eye = GetVector(camera_node->first_node("Eye"));
@@ -150,27 +361,43 @@ Scene *SceneManager::LoadScene(const std::string &name_) {
 
         scene->global_lighting_ = new GlobalLighting();
 
-        index = 0;
+        std::vector<LightUBO> &lights = scene->global_lighting_->lights;
         for (auto node = lights_node->first_node(); node; node = node->next_sibling()) {
+            if (std::string(node->name()) == "Generate") {
+                GenerateLights(node, lights);
+                continue;
+            }
+            if (std::string(node->name()) == "Sun") {
+                const glm::vec3 direction = glm::normalize(GetVector(node->first_node("Direction")));
+                scene->global_lighting_->sun = {glm::vec4(direction, 1.0f), GetVector4(node->first_node("Diffuse"))};
+                continue;
+            }
+            // Position w is the range; <Light range="R"> sets it, it defaults otherwise.
             glm::vec4 pos = GetVector4(node->first_node("Position"));
+            pos.w = std::stof(GetAttribute(node, "range", std::to_string(kDefaultLightRange)));
             glm::vec4 diff = GetVector4(node->first_node("Diffuse"));
-            scene->global_lighting_->lights[index] = {pos, diff};
-            index++;
+            if (GetAttribute(node, "shadows", "false") == "true")
+                scene->global_lighting_->shadow_casters.push_back(static_cast<std::uint32_t>(lights.size()));
+            lights.push_back({pos, diff});
         }
-
-        scene->global_lighting_->numLights = index;
+        spdlog::info("{} point lights", lights.size());
 
         camera->Perspective(glm::radians(pers.x), size.x / size.y, pers.y, pers.z);
-        camera->LookAt(eye, center, up);
-        trackball->SetInitialView(eye, center, up);
+        initialView = {eye, center, up};
+        SetCameraView(initialView);
 
-        // Set view and projection in renderer
-        vRenderer->SetViewProjection(camera->GetViewMatrix(), camera->GetProjectionMatrix(), eye);
+        // <Vertices compact="true"/> uploads every model quantized; the format
+        // is renderer-wide, so it has to be chosen before the first model loads.
+        const auto *vertices_node = state_node->first_node("Vertices");
+        const bool compact = vertices_node && GetAttribute(vertices_node, "compact", "false") == "true";
+        vRenderer->SetVertexFormat(compact ? VertexFormat::Compact : VertexFormat::Float);
 
         LoadActors(vRenderer, baseNode->first_node("Actors"), scene);
         vRenderer->cubemap_ = names;
         vRenderer->CreateSkyboxResources();
     }
 
+    loadTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_begin).count();
+    spdlog::info("Loaded {} in {:.1f} ms", name_, loadTimeMs);
     return scene;
 }
@@ -9,15 +9,37 @@
 #include <render/Scene.h>
 #include <window/Window.h>
 
+class Timer;
+
+struct CameraView {
+    glm::vec3 eye{0.0f};
+    glm::vec3 center{0.0f};
+    glm::vec3 up{0.0f, 1.0f, 0.0f};
+};
 
 class SceneManager {
 public:
     explicit SceneManager(RendererType render_type_);
     ~SceneManager();
     void Run();
-    bool Initialize(const std::string& name_, int width_, int height_);
+    bool Initialize(const std::string& name_, int width_, int height_,
+                    const std::string& scene_ = "./assets/scenes/Scene1.xml");
+    /// No window, input or frame limiter; frames are only produced by RenderFrame.
+    bool InitializeHeadless(const std::string& scene_, int width_, int height_);
     void GetEvents();
 
+    /// Records, submits and presents one frame. Returns false if the frame was
+    /// skipped (e.g. the swapchain had to be recreated).
+    bool RenderFrame();
+    /// Moves the camera (through the trackball when there is one) and updates
+    /// the renderer's view.
+    void SetCameraView(const CameraView& view_);
+
+    [[nodiscard]] Renderer* GetRenderer() const { return renderer; }
+    [[nodiscard]] Timer* GetTimer() const { return timer; }
+    [[nodiscard]] const CameraView& GetInitialCameraView() const { return initialView; }
+    [[nodiscard]] double GetLoadTimeMs() const { return loadTimeMs; }
+
     enum SCENE_NUMBER {
         SCENE0 = 0,
         SCENE1 = 1,
@@ -41,6 +63,11 @@ private:
     Renderer* renderer;
     unsigned int fps;
     bool isRunning;
+    unsigned int frameCount = 0;
+    std::unordered_map<int, bool> keyStates;
+    CameraView initialView;
+    double loadTimeMs = 0.0;
     void BuildScene(SCENE_NUMBER scene_);
+    void ReportFrameTimings() const;
     Scene* LoadScene(const std::string &name_);
 };
@@ -4,9 +4,13 @@
 
 #pragma once
 
+constexpr std::uint32_t kNoTextureIndex = UINT32_MAX;
+
 struct TextureHandle {
     VkImage image = VK_NULL_HANDLE;
     VkImageView image_view = VK_NULL_HANDLE;
     VkDeviceMemory memory = VK_NULL_HANDLE;
     VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+    /// Slot in the bindless texture table, which replaces descriptor_set when in use.
+    std::uint32_t texture_index = kNoTextureIndex;
 };
\ No newline at end of file
@@ -0,0 +1,49 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <ThreadPool.h>
+
+#include <Profiler.h>
+
+ThreadPool::ThreadPool(const std::size_t thread_count, const std::string &name) {
+    workers_.reserve(thread_count);
+    for (std::size_t i = 0; i < thread_count; ++i)
+        workers_.emplace_back(&ThreadPool::WorkerLoop, this, name + " " + std::to_string(i));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (std::thread &worker: workers_)
+        worker.join();
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task) {
+    std::packaged_task<void()> packaged(std::move(task));
+    std::future<void> future = packaged.get_future();
+    {
+        std::lock_guard lock(mutex_);
+        tasks_.push_back(std::move(packaged));
+    }
+    wake_.notify_one();
+    return future;
+}
+
+void ThreadPool::WorkerLoop(const std::string &name) {
+    PROFILE_THREAD(name);
+    while (true) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) return;
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,39 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Fixed set of worker threads running queued tasks in submission order.
+class ThreadPool {
+public:
+    /// Starts thread_count workers, named "<name> <index>" in profiler traces.
+    ThreadPool(std::size_t thread_count, const std::string &name);
+    /// Finishes every queued task, then joins the workers.
+    ~ThreadPool();
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// The future becomes ready once the task ran; it rethrows what the task threw.
+    std::future<void> Submit(std::function<void()> task);
+
+    [[nodiscard]] std::size_t GetThreadCount() const { return workers_.size(); }
+
+private:
+    void WorkerLoop(const std::string &name);
+
+    std::vector<std::thread> workers_;
+    std::deque<std::packaged_task<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+};
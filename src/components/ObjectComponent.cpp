@@ -7,44 +7,192 @@
 #include <tiny_obj_loader.h>
 #include <components/Actor.h>
 #include <components/TransformComponent.h>
+#include <Profiler.h>
+
+#include <glm/gtc/packing.hpp>
+
+std::unordered_map<std::string, ObjectAsset*> ObjectComponent::assets_;
+
+namespace {
+    // Projects the unit normal onto the octahedron |x| + |y| + |z| = 1 and
+    // folds the lower half over the upper, leaving a point in [-1, 1]^2.
+    glm::vec2 OctahedralEncode(const glm::vec3 &normal) {
+        const glm::vec3 n = normal / (std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z));
+        if (n.z >= 0.0f) return {n.x, n.y};
+        return {(1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f)};
+    }
+}
+
+oCompactVertex oCompactVertex::Encode(const oVertex &vertex, const PositionDecode &position_decode) {
+    oCompactVertex compact{};
+    for (int axis = 0; axis < 3; axis++) {
+        // A flat axis has no extent to divide by; every vertex sits at its offset.
+        const float scale = position_decode.scale[axis];
+        const float unit = scale > 0.0f ? (vertex.position[axis] - position_decode.offset[axis]) / scale : 0.0f;
+        compact.position[axis] = glm::packUnorm1x16(unit);
+    }
+
+    const glm::vec2 octahedral = glm::length(vertex.normal) > 0.0f
+                                     ? OctahedralEncode(vertex.normal)
+                                     : glm::vec2(0.0f);
+    compact.normal[0] = static_cast<std::int16_t>(glm::packSnorm1x16(octahedral.x));
+    compact.normal[1] = static_cast<std::int16_t>(glm::packSnorm1x16(octahedral.y));
+    compact.texCoord[0] = glm::packHalf1x16(vertex.texCoord.x);
+    compact.texCoord[1] = glm::packHalf1x16(vertex.texCoord.y);
+    return compact;
+}
 
 bool ObjectComponent::OnCreate() {
     return true;
 }
 
 void ObjectComponent::OnDestroy() {
-    if (buffer_.buffer != VK_NULL_HANDLE) {
-        vk_renderer_->DestroyBuffer(buffer_);
-    }
-    if (index_buffer_.buffer != VK_NULL_HANDLE) {
-        vk_renderer_->DestroyBuffer(index_buffer_);
+    ReleaseAsset();
+}
+
+void ObjectComponent::Update(float deltaTime) {
+}
+
+void ObjectComponent::Render() const {
+    vk_renderer_->RenderModel(asset_->vertex_buffer, asset_->index_buffer, asset_->meshes, asset_->texture_handles,
+                              asset_->material_ubos,
+                              dynamic_cast<Actor*>(parent)->GetComponent<TransformComponent>()->GetTransformMatrix(),
+                              asset_->position_decode);
+}
+
+ObjectAsset* ObjectComponent::AcquireAsset() {
+    if (const auto it = assets_.find(obj_); it != assets_.end()) {
+        it->second->references++;
+        return it->second;
     }
-    
-    // Destroy all texture handles
-    for (auto& texture_handle : texture_handles_) {
-        if (texture_handle.image != VK_NULL_HANDLE) {
-            vk_renderer_->DestroyTexture(texture_handle);
+
+    loadObj();
+
+    auto* asset = new ObjectAsset();
+    OptimizeMeshes(asset);
+    SplitMeshes();
+    if (!vertices_.empty()) {
+        asset->bounds_min = asset->bounds_max = vertices_.front().position;
+        for (const auto &vertex: vertices_) {
+            asset->bounds_min = glm::min(asset->bounds_min, vertex.position);
+            asset->bounds_max = glm::max(asset->bounds_max, vertex.position);
         }
     }
-    texture_handles_.clear();
+    if (vk_renderer_->GetVertexFormat() == VertexFormat::Compact) {
+        asset->position_decode = {asset->bounds_min, asset->bounds_max - asset->bounds_min};
+        std::vector<oCompactVertex> compact_vertices;
+        compact_vertices.reserve(vertices_.size());
+        for (const auto &vertex: vertices_)
+            compact_vertices.push_back(oCompactVertex::Encode(vertex, asset->position_decode));
+        asset->vertex_buffer = vk_renderer_->CreateVertexBuffer(compact_vertices);
+    } else {
+        asset->vertex_buffer = vk_renderer_->CreateVertexBuffer(getOVertices());
+    }
+    asset->index_buffer = vk_renderer_->CreateIndexBuffer(getIndices());
+    for (const auto &texture: getTextures())
+        asset->texture_handles.push_back(vk_renderer_->CreateTexture(texture.c_str()));
+    asset->meshes = getMeshes();
+    asset->material_ubos = getMaterialUBOs();
+    asset->references = 1;
+
+    // The GPU copy is all that is needed from here on.
+    vertices_ = {};
+    materials_ = {};
+    meshes_ = {};
+
+    assets_.emplace(obj_, asset);
+    return asset;
 }
 
-void ObjectComponent::Update(float deltaTime) {
+std::pair<VertexCacheStats, VertexCacheStats> ObjectComponent::GetVertexCacheStats() {
+    std::pair<VertexCacheStats, VertexCacheStats> stats;
+    for (const auto& [obj, asset]: assets_) {
+        stats.first += asset->cache_before;
+        stats.second += asset->cache_after;
+    }
+    return stats;
 }
 
-void ObjectComponent::Render() const {
-    vk_renderer_->RenderModel(buffer_, index_buffer_, getMeshes(), texture_handles_, getMaterialUBOs(),
-                              dynamic_cast<Actor*>(parent)->GetComponent<TransformComponent>()->GetTransformMatrix());
+// Meshes are drawn one per material, so each keeps its own index range and
+// only its triangles are reordered. The vertex buffer is shared, so the fetch
+// order comes from all of them together, in draw order.
+void ObjectComponent::OptimizeMeshes(ObjectAsset* asset) {
+    PROFILE_FUNCTION();
+    std::vector<glm::vec3> positions;
+    positions.reserve(vertices_.size());
+    for (const auto &vertex: vertices_)
+        positions.push_back(vertex.position);
+
+    for (auto &mesh: meshes_) {
+        asset->cache_before += AnalyzeVertexCache(mesh.indices, vertices_.size());
+        const std::vector<std::uint32_t> clusters = OptimizeVertexCache(mesh.indices, vertices_.size());
+        OptimizeOverdraw(mesh.indices, clusters, positions);
+        asset->cache_after += AnalyzeVertexCache(mesh.indices, vertices_.size());
+    }
+
+    std::vector<std::uint32_t> indices = getIndices();
+    const std::vector<std::uint32_t> remap = OptimizeVertexFetch(indices, vertices_.size());
+    std::vector<oVertex> vertices;
+    vertices.reserve(vertices_.size());
+    for (std::size_t vertex = 0; vertex < vertices_.size(); vertex++) {
+        if (remap[vertex] == kUnusedVertex) continue;
+        if (remap[vertex] >= vertices.size()) vertices.resize(remap[vertex] + 1);
+        vertices[remap[vertex]] = vertices_[vertex];
+    }
+    vertices_ = std::move(vertices);
+
+    std::size_t offset = 0;
+    for (auto &mesh: meshes_) {
+        std::copy_n(indices.begin() + static_cast<std::ptrdiff_t>(offset), mesh.indices.size(), mesh.indices.begin());
+        offset += mesh.indices.size();
+    }
+
+    spdlog::info("{}: ACMR {:.3f} -> {:.3f}", obj_, asset->cache_before.GetAcmr(), asset->cache_after.GetAcmr());
+}
+
+// Meshes reaching past 65536 vertices become several, each drawn from its
+// own base vertex, so the whole index buffer can be 16-bit.
+void ObjectComponent::SplitMeshes() {
+    std::vector<Mesh> meshes;
+    meshes.reserve(meshes_.size());
+    for (auto &mesh: meshes_) {
+        for (const IndexChunk &chunk: SplitIndexChunks(mesh.indices)) {
+            const auto first = mesh.indices.begin() + chunk.first_index;
+            meshes.push_back({{first, first + chunk.index_count}, mesh.materialId, chunk.base_vertex});
+        }
+    }
+    meshes_ = std::move(meshes);
+}
+
+void ObjectComponent::ReleaseAsset() {
+    if (asset_ == nullptr) return;
+
+    if (--asset_->references == 0) {
+        if (asset_->vertex_buffer.buffer != VK_NULL_HANDLE)
+            vk_renderer_->DestroyBuffer(asset_->vertex_buffer);
+        if (asset_->index_buffer.buffer != VK_NULL_HANDLE)
+            vk_renderer_->DestroyBuffer(asset_->index_buffer);
+        for (auto& texture_handle : asset_->texture_handles) {
+            if (texture_handle.image != VK_NULL_HANDLE) {
+                vk_renderer_->DestroyTexture(texture_handle);
+            }
+        }
+        assets_.erase(obj_);
+        delete asset_;
+    }
+    asset_ = nullptr;
 }
 
 void ObjectComponent::loadObj() {
+    PROFILE_FUNCTION();
     tinyobj::attrib_t attrib_t;
     std::vector<tinyobj::shape_t> shapes;
     std::vector<tinyobj::material_t> materials;
 
     std::string err;
 
-    bool ret = LoadObj(&attrib_t, &shapes, &materials, &err, obj_, basedir_, true);
+    bool ret = LoadObj(&attrib_t, &shapes, &materials, &err, obj_.c_str(), basedir_.c_str(), true);
     if (!err.empty()) {
         std::cerr << "ERR: " << err << std::endl;
     }
@@ -66,7 +214,7 @@ void ObjectComponent::loadObj() {
     for (unsigned int i = 0; i < attrib_t.texcoords.size(); i += 2)
         texCoords.emplace_back(attrib_t.texcoords[i + 0], 1 - (attrib_t.texcoords[i + 1]));
 
-    std::unordered_map<oVertex, int, VertexHash> indices;
+    std::unordered_map<oVertex, std::uint32_t, VertexHash> indices;
 
     for (const auto& [name, mesh] : shapes) {
         Mesh m;
@@ -80,9 +228,10 @@ void ObjectComponent::loadObj() {
             if (auto index = indices.find(v); index != indices.end()) {
                 m.indices.push_back(index->second);
             } else {
-                m.indices.push_back(vertices_.size());
+                const auto new_index = static_cast<std::uint32_t>(vertices_.size());
+                m.indices.push_back(new_index);
 
-                indices.emplace(v, vertices_.size());
+                indices.emplace(v, new_index);
 
                 vertices_.push_back(v);
             }
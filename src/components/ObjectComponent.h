@@ -4,11 +4,14 @@
 
 #pragma once
 #include <components/Component.h>
+#include <render/MeshOptimizer.h>
 #include <render/VulkanRenderer.h>
 
 struct Mesh {
-    std::vector<int> indices;
+    std::vector<std::uint32_t> indices;
     int materialId;
+    /// Vertex the indices count from, so each mesh stays within 16-bit indices.
+    std::uint32_t baseVertex = 0;
 };
 
 struct Material_UBO {
@@ -67,16 +70,55 @@ struct VertexHash {
     }
 };
 
+// oVertex in 16 bytes instead of 32: positions as unorm16 across the mesh
+// bounds, normals octahedral-encoded in two snorm16 and uvs as half floats.
+// The draw's PositionDecode maps positions back; basic_compact.vert unfolds
+// the normals.
+struct oCompactVertex {
+    std::uint16_t position[4]; // w only pads to a four-component format
+    std::int16_t normal[2];
+    std::uint16_t texCoord[2];
+
+    static oCompactVertex Encode(const oVertex &vertex, const PositionDecode &position_decode);
+
+    static VkVertexInputBindingDescription GetBindingDescription() {
+        return VkVertexInputBindingDescription{0, sizeof(oCompactVertex), VK_VERTEX_INPUT_RATE_VERTEX};
+    }
+
+    static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() {
+        return {
+            {0, 0, VK_FORMAT_R16G16B16A16_UNORM, offsetof(oCompactVertex, position)},
+            {1, 0, VK_FORMAT_R16G16_SNORM, offsetof(oCompactVertex, normal)},
+            {2, 0, VK_FORMAT_R16G16_SFLOAT, offsetof(oCompactVertex, texCoord)}
+        };
+    }
+};
+
+// GPU resources of one OBJ file. Every ObjectComponent loading the same file
+// shares a single asset, so scenes with many instances of a model only parse
+// and upload it once.
+struct ObjectAsset {
+    BufferHandle vertex_buffer;
+    BufferHandle index_buffer;
+    std::vector<Mesh> meshes;
+    std::vector<Material_UBO> material_ubos;
+    std::vector<TextureHandle> texture_handles;
+    glm::vec3 bounds_min{0.0f};
+    glm::vec3 bounds_max{0.0f};
+    /// Identity unless the vertices are oCompactVertex.
+    PositionDecode position_decode;
+    /// Post-transform cache misses of the indices as loaded and as uploaded.
+    VertexCacheStats cache_before;
+    VertexCacheStats cache_after;
+    std::uint32_t references = 0;
+};
+
 class ObjectComponent : public Component{
 
 public:
     ObjectComponent(const char *obj, const char *basedir, Component* parent, VulkanRenderer* renderer ) : Component(parent),
         obj_(obj), basedir_(basedir), vk_renderer_(renderer) {
-        loadObj();
-        buffer_ = vk_renderer_->CreateVertexBuffer(getOVertices());
-        index_buffer_ = vk_renderer_->CreateIndexBuffer(getIndices());
-        for (const auto &texture: getTextures())
-            texture_handles_.push_back(vk_renderer_->CreateTexture(texture.c_str()));
+        asset_ = AcquireAsset();
     };
 
     bool OnCreate() override;
@@ -84,6 +126,10 @@ public:
     void Update(float deltaTime) override;
     void Render() const override;
 
+    [[nodiscard]] const ObjectAsset* getAsset() const { return asset_; }
+    /// Summed over every loaded model: the cache misses before and after OptimizeMeshes.
+    static std::pair<VertexCacheStats, VertexCacheStats> GetVertexCacheStats();
+
     std::vector<oVertex> getOVertices() {
         return vertices_;
     };
@@ -118,15 +164,18 @@ for (const auto& [bp_material_ubo_, diffuse_texName]: materials_) {
     }
 
 private:
-    const char *obj_;
-    const char *basedir_;
+    std::string obj_;
+    std::string basedir_;
     std::vector<oVertex> vertices_;
     std::vector<material> materials_;
     std::vector<Mesh> meshes_;
     void loadObj();
+    void OptimizeMeshes(ObjectAsset* asset);
+    void SplitMeshes();
+    ObjectAsset* AcquireAsset();
+    void ReleaseAsset();
     VulkanRenderer* vk_renderer_;
-    BufferHandle buffer_;
-    BufferHandle index_buffer_;
-    mutable std::vector<TextureHandle> texture_handles_;
-};
+    ObjectAsset* asset_ = nullptr;
 
+    static std::unordered_map<std::string, ObjectAsset*> assets_;
+};
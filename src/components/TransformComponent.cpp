@@ -8,13 +8,17 @@ TransformComponent::TransformComponent(Component* parent_):Component(parent_) {
     pos = glm::vec3(0.0f, 0.0f, 0.0f);
     orientation = glm::quat(1.0f, glm::vec3(0.0f, 0.0f, 0.0f));
     scale = glm::vec3(1.0f, 1.0f, 1.0f);
+    revision++;
 }
 
 TransformComponent::TransformComponent(Component* parent_, glm::vec3 pos_, glm::quat orientation_, glm::vec3 scale_):
     Component{ parent_ }, pos{ pos_ }, orientation{ orientation_ }, scale{ scale_ } {
+    revision++;
 }
 
-TransformComponent::~TransformComponent() = default;
+TransformComponent::~TransformComponent() {
+    revision++;
+}
 
 bool TransformComponent::OnCreate() {
     if (isCreated == true) return true;
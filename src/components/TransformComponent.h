@@ -23,11 +23,16 @@ public:
         pos = pos_;
         orientation = orientation_;
         scale = scale_;
+        revision++;
     }
+    /// Changes whenever any transform is created, moved or destroyed. Cached
+    /// shadow maps are re-rendered when it does.
+    [[nodiscard]] static std::uint64_t GetRevision() { return revision; }
 
 private:
     glm::vec3 pos{};
     glm::vec3 scale{};
     glm::quat orientation{};
+    static inline std::uint64_t revision = 0;
 
 };
\ No newline at end of file
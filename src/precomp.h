@@ -6,6 +6,7 @@
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
+#include <chrono>
 #include <cmath>
 #include <cstdlib>
 #include <cstdint>
@@ -0,0 +1,118 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/DrawList.h>
+
+#include <algorithm>
+#include <type_traits>
+
+namespace {
+    // Key layout, high to low bits: pipeline, texture, vertex buffer, index buffer.
+    constexpr std::uint32_t kPipelineBits = 8;
+    constexpr std::uint32_t kTextureBits = 20;
+    constexpr std::uint32_t kBufferBits = 18;
+
+    // Non-dispatchable handles are pointers on 64-bit targets and integers
+    // elsewhere.
+    template<typename Handle>
+    std::uint64_t HandleBits(const Handle handle) {
+        if constexpr (std::is_pointer_v<Handle>)
+            return reinterpret_cast<std::uintptr_t>(handle);
+        else
+            return handle;
+    }
+}
+
+BindCounts &BindCounts::operator+=(const BindCounts &other) {
+    pipelines += other.pipelines;
+    descriptor_sets += other.descriptor_sets;
+    vertex_buffers += other.vertex_buffers;
+    index_buffers += other.index_buffers;
+    push_constants += other.push_constants;
+    return *this;
+}
+
+void DrawList::Clear() {
+    packets_.clear();
+    transforms_.clear();
+    position_decodes_.clear();
+}
+
+std::uint32_t DrawList::AddTransform(const glm::mat4 &transform, const PositionDecode &position_decode) {
+    transforms_.push_back({transform});
+    position_decodes_.push_back(position_decode);
+    return static_cast<std::uint32_t>(transforms_.size() - 1);
+}
+
+// The inverse transpose is the cofactor matrix over the determinant, and the
+// cofactor columns are cross products of the model's columns. No branches, so
+// the loop over the packed transforms vectorizes. Normals are not quantized,
+// so their matrix comes from the model before the decode is folded in.
+void DrawList::FinalizeTransforms() {
+    for (std::size_t i = 0; i < transforms_.size(); ++i) {
+        DrawTransform &transform = transforms_[i];
+        const glm::vec3 x(transform.model[0]);
+        const glm::vec3 y(transform.model[1]);
+        const glm::vec3 z(transform.model[2]);
+        const glm::vec3 cofactor_x = glm::cross(y, z);
+        const glm::vec3 cofactor_y = glm::cross(z, x);
+        const glm::vec3 cofactor_z = glm::cross(x, y);
+        const float determinant = glm::dot(x, cofactor_x);
+        // A model scaled to nothing keeps zero normals rather than infinities.
+        const float inverse_determinant = determinant != 0.0f ? 1.0f / determinant : 0.0f;
+        transform.normal = glm::mat3x4(glm::vec4(cofactor_x * inverse_determinant, 0.0f),
+                                       glm::vec4(cofactor_y * inverse_determinant, 0.0f),
+                                       glm::vec4(cofactor_z * inverse_determinant, 0.0f));
+
+        const PositionDecode &decode = position_decodes_[i];
+        transform.model[3] = transform.model * glm::vec4(decode.offset, 1.0f);
+        transform.model[0] *= decode.scale.x;
+        transform.model[1] *= decode.scale.y;
+        transform.model[2] *= decode.scale.z;
+    }
+}
+
+void DrawList::Add(VkPipeline pipeline, VkDescriptorSet texture_set, const std::uint32_t texture_index,
+                   VkBuffer vertex_buffer, VkBuffer index_buffer, const VkIndexType index_type,
+                   const std::uint32_t first_index, const std::uint32_t index_count, const std::int32_t vertex_offset,
+                   const std::uint32_t transform) {
+    DrawPacket packet;
+    packet.key = GetStateId(HandleBits(pipeline), 0, kPipelineBits) << (kTextureBits + 2 * kBufferBits) |
+                 GetStateId(HandleBits(texture_set), texture_index, kTextureBits) << 2 * kBufferBits |
+                 GetStateId(HandleBits(vertex_buffer), 0, kBufferBits) << kBufferBits |
+                 GetStateId(HandleBits(index_buffer), 0, kBufferBits);
+    packet.pipeline = pipeline;
+    packet.texture_set = texture_set;
+    packet.texture_index = texture_index;
+    packet.vertex_buffer = vertex_buffer;
+    packet.index_buffer = index_buffer;
+    packet.index_type = index_type;
+    packet.first_index = first_index;
+    packet.index_count = index_count;
+    packet.vertex_offset = vertex_offset;
+    packet.transform = transform;
+    packets_.push_back(packet);
+}
+
+void DrawList::Sort() {
+    std::stable_sort(packets_.begin(), packets_.end(), [](const DrawPacket &a, const DrawPacket &b) {
+        return a.key < b.key;
+    });
+}
+
+void DrawList::ReleaseBuffer(VkBuffer buffer) {
+    state_ids_.erase({HandleBits(buffer), 0});
+}
+
+void DrawList::ReleaseTexture(VkDescriptorSet texture_set, const std::uint32_t texture_index) {
+    state_ids_.erase({HandleBits(texture_set), texture_index});
+}
+
+// Ids are handed out in first-seen order. Ids that outgrow their field wrap
+// around; that only costs some sorting, binds compare the handles themselves.
+std::uint64_t DrawList::GetStateId(const std::uint64_t handle, const std::uint32_t element, const std::uint32_t bits) {
+    const auto [it, inserted] = state_ids_.try_emplace({handle, element}, next_state_id_);
+    if (inserted) next_state_id_++;
+    return it->second & ((1ull << bits) - 1);
+}
@@ -0,0 +1,106 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// One indexed draw with everything it binds. The key orders packets by
+// pipeline, then texture, then vertex and index buffer, so sorted packets
+// that share state end up next to each other.
+struct DrawPacket {
+    std::uint64_t key = 0;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorSet texture_set = VK_NULL_HANDLE;
+    /// Slot in texture_set when it is a bindless texture table.
+    std::uint32_t texture_index = 0;
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    VkIndexType index_type = VK_INDEX_TYPE_UINT32;
+    std::uint32_t first_index = 0;
+    std::uint32_t index_count = 0;
+    /// Added to every index, for meshes split into 16-bit chunks.
+    std::int32_t vertex_offset = 0;
+    std::uint32_t transform = 0;
+};
+
+// What a draw pushes before its texture index. Each column of normal is a
+// vec4, the way a GLSL mat3 is laid out in a push constant block.
+struct DrawTransform {
+    glm::mat4 model{1.0f};
+    /// Inverse transpose of the model's upper 3x3, filled in by FinalizeTransforms.
+    glm::mat3x4 normal{1.0f};
+};
+
+// Maps quantized vertex positions back to model space: offset + position * scale.
+struct PositionDecode {
+    glm::vec3 offset{0.0f};
+    glm::vec3 scale{1.0f};
+};
+
+// State changes actually recorded, after redundant ones were skipped.
+struct BindCounts {
+    std::uint32_t pipelines = 0;
+    std::uint32_t descriptor_sets = 0;
+    std::uint32_t vertex_buffers = 0;
+    std::uint32_t index_buffers = 0;
+    std::uint32_t push_constants = 0;
+
+    BindCounts &operator+=(const BindCounts &other);
+};
+
+/// Draw packets of one frame. Whoever records them keeps track of what is
+/// bound and only binds what changes from one packet to the next.
+class DrawList {
+public:
+    /// Drops the packets and transforms. Handle ids, and so the sort order
+    /// of the same state, stay the same from frame to frame.
+    void Clear();
+    std::uint32_t AddTransform(const glm::mat4 &transform, const PositionDecode &position_decode = {});
+    /// Derives every transform's normal matrix and folds its position decode
+    /// into the model matrix, in one pass. Call once all transforms are in
+    /// and before recording.
+    void FinalizeTransforms();
+    void Add(VkPipeline pipeline, VkDescriptorSet texture_set, std::uint32_t texture_index, VkBuffer vertex_buffer,
+             VkBuffer index_buffer, VkIndexType index_type, std::uint32_t first_index, std::uint32_t index_count,
+             std::int32_t vertex_offset, std::uint32_t transform);
+    /// Sorts by key. Packets with equal keys keep the order they were added
+    /// in, so the meshes of one model stay together.
+    void Sort();
+    /// Forgets the id of a destroyed buffer, so the handle value can be
+    /// reused without keeping a stale entry around.
+    void ReleaseBuffer(VkBuffer buffer);
+    /// Forgets the id of a destroyed texture: its descriptor set, or its slot
+    /// in a texture table.
+    void ReleaseTexture(VkDescriptorSet texture_set, std::uint32_t texture_index);
+
+    [[nodiscard]] std::span<const DrawPacket> GetPackets() const { return packets_; }
+    [[nodiscard]] const DrawTransform &GetTransform(std::uint32_t transform) const { return transforms_[transform]; }
+
+private:
+    using StateKey = std::pair<std::uint64_t, std::uint32_t>;
+
+    struct StateKeyHash {
+        std::size_t operator()(const StateKey &key) const {
+            return std::hash<std::uint64_t>{}(key.first ^ static_cast<std::uint64_t>(key.second) << 48);
+        }
+    };
+
+    std::uint64_t GetStateId(std::uint64_t handle, std::uint32_t element, std::uint32_t bits);
+
+    std::vector<DrawPacket> packets_;
+    std::vector<DrawTransform> transforms_;
+    std::vector<PositionDecode> position_decodes_;
+    /// Keyed by handle and, for texture tables, the slot in it.
+    std::unordered_map<StateKey, std::uint64_t, StateKeyHash> state_ids_;
+    /// Not the map's size: released ids are not handed out again.
+    std::uint64_t next_state_id_ = 0;
+};
@@ -0,0 +1,89 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/ImageBarrier.h>
+
+#include <vector>
+
+namespace {
+    // The first 32 bits of the synchronization2 flags match the legacy ones;
+    // only the split stages and accesses need folding back.
+    VkPipelineStageFlags ToLegacyStages(const VkPipelineStageFlags2 stages) {
+        auto legacy = static_cast<VkPipelineStageFlags>(stages & 0xFFFFFFFFull);
+        if (stages & (VK_PIPELINE_STAGE_2_COPY_BIT | VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_RESOLVE_BIT |
+                      VK_PIPELINE_STAGE_2_CLEAR_BIT))
+            legacy |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        if (stages & (VK_PIPELINE_STAGE_2_INDEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_ATTRIBUTE_INPUT_BIT))
+            legacy |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+        return legacy;
+    }
+
+    VkAccessFlags ToLegacyAccess(const VkAccessFlags2 access) {
+        auto legacy = static_cast<VkAccessFlags>(access & 0xFFFFFFFFull);
+        if (access & (VK_ACCESS_2_SHADER_SAMPLED_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT))
+            legacy |= VK_ACCESS_SHADER_READ_BIT;
+        if (access & VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT)
+            legacy |= VK_ACCESS_SHADER_WRITE_BIT;
+        return legacy;
+    }
+}
+
+void RecordImageBarriers(VkCommandBuffer command_buffer, const std::span<const ImageBarrier> barriers,
+                         const bool synchronization2) {
+    if (barriers.empty()) return;
+
+    if (synchronization2) {
+        std::vector<VkImageMemoryBarrier2> image_barriers;
+        image_barriers.reserve(barriers.size());
+        for (const ImageBarrier &barrier: barriers) {
+            VkImageMemoryBarrier2 image_barrier{};
+            image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+            image_barrier.srcStageMask = barrier.src_stages;
+            image_barrier.srcAccessMask = barrier.src_access;
+            image_barrier.dstStageMask = barrier.dst_stages;
+            image_barrier.dstAccessMask = barrier.dst_access;
+            image_barrier.oldLayout = barrier.old_layout;
+            image_barrier.newLayout = barrier.new_layout;
+            image_barrier.srcQueueFamilyIndex = barrier.src_queue_family;
+            image_barrier.dstQueueFamilyIndex = barrier.dst_queue_family;
+            image_barrier.image = barrier.image;
+            image_barrier.subresourceRange = {barrier.aspect, 0, 1, 0, barrier.layer_count};
+            image_barriers.push_back(image_barrier);
+        }
+
+        VkDependencyInfo dependency{};
+        dependency.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependency.imageMemoryBarrierCount = static_cast<std::uint32_t>(image_barriers.size());
+        dependency.pImageMemoryBarriers = image_barriers.data();
+        vkCmdPipelineBarrier2(command_buffer, &dependency);
+        return;
+    }
+
+    VkPipelineStageFlags src_stages = 0;
+    VkPipelineStageFlags dst_stages = 0;
+    std::vector<VkImageMemoryBarrier> image_barriers;
+    image_barriers.reserve(barriers.size());
+    for (const ImageBarrier &barrier: barriers) {
+        VkImageMemoryBarrier image_barrier{};
+        image_barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        image_barrier.srcAccessMask = ToLegacyAccess(barrier.src_access);
+        image_barrier.dstAccessMask = ToLegacyAccess(barrier.dst_access);
+        image_barrier.oldLayout = barrier.old_layout;
+        image_barrier.newLayout = barrier.new_layout;
+        image_barrier.srcQueueFamilyIndex = barrier.src_queue_family;
+        image_barrier.dstQueueFamilyIndex = barrier.dst_queue_family;
+        image_barrier.image = barrier.image;
+        image_barrier.subresourceRange = {barrier.aspect, 0, 1, 0, barrier.layer_count};
+        image_barriers.push_back(image_barrier);
+
+        src_stages |= ToLegacyStages(barrier.src_stages);
+        dst_stages |= ToLegacyStages(barrier.dst_stages);
+    }
+
+    // Legacy barriers cannot have empty stage masks.
+    if (src_stages == 0) src_stages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    if (dst_stages == 0) dst_stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    vkCmdPipelineBarrier(command_buffer, src_stages, dst_stages, 0, 0, nullptr, 0, nullptr,
+                         static_cast<std::uint32_t>(image_barriers.size()), image_barriers.data());
+}
@@ -0,0 +1,33 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <span>
+
+/// Layout transition and memory dependency for one image, in
+/// synchronization2 terms. Stages left as NONE mean "nothing to wait for" on
+/// the source side and "nothing waits" on the destination side.
+struct ImageBarrier {
+    VkImage image = VK_NULL_HANDLE;
+    VkImageLayout old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout new_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 src_access = VK_ACCESS_2_NONE;
+    VkPipelineStageFlags2 dst_stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 dst_access = VK_ACCESS_2_NONE;
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    std::uint32_t layer_count = 1;
+    std::uint32_t src_queue_family = VK_QUEUE_FAMILY_IGNORED;
+    std::uint32_t dst_queue_family = VK_QUEUE_FAMILY_IGNORED;
+};
+
+/// Records the barriers with vkCmdPipelineBarrier2, each with its own stages,
+/// or, without synchronization2, as one legacy vkCmdPipelineBarrier whose
+/// stage masks are the union of all of them.
+void RecordImageBarriers(VkCommandBuffer command_buffer, std::span<const ImageBarrier> barriers,
+                         bool synchronization2);
@@ -0,0 +1,98 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/LightClusters.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // glm::perspective maps the far plane to NDC depth 1 and the near plane
+    // to -1, or to 0 when glm is set up for a zero to one depth range.
+#if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_ZO_BIT
+    constexpr float kNearNdcDepth = 0.0f;
+#else
+    constexpr float kNearNdcDepth = -1.0f;
+#endif
+
+    std::uint32_t ToTile(const float ndc, const std::uint32_t tiles) {
+        const float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(tiles));
+        return static_cast<std::uint32_t>(std::clamp(tile, 0.0f, static_cast<float>(tiles - 1)));
+    }
+
+    std::uint32_t ClusterIndex(const std::uint32_t x, const std::uint32_t y, const std::uint32_t z) {
+        return x + kClusterTilesX * (y + kClusterTilesY * z);
+    }
+}
+
+void LightClusters::Build(const std::span<const LightUBO> lights, const glm::mat4 &view,
+                          const glm::mat4 &projection, const glm::vec2 extent) {
+    const float near = projection[3][2] / (kNearNdcDepth + projection[2][2]);
+    const float far = projection[3][2] / (1.0f + projection[2][2]);
+    const float log_range = std::log(far / near);
+    const float slice_scale = static_cast<float>(kClusterSlices) / log_range;
+    const float slice_bias = -static_cast<float>(kClusterSlices) * std::log(near) / log_range;
+    const auto to_slice = [slice_scale, slice_bias](const float depth) {
+        const float slice = std::floor(std::log(depth) * slice_scale + slice_bias);
+        return static_cast<std::uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(kClusterSlices - 1)));
+    };
+
+    header_.dims = {kClusterTilesX, kClusterTilesY, kClusterSlices, static_cast<std::uint32_t>(lights.size())};
+    header_.slicing = {slice_scale, slice_bias, extent.x / kClusterTilesX, extent.y / kClusterTilesY};
+
+    // Bound every light by its view-space box; lights straddling the near
+    // plane cover the whole screen.
+    bounds_.clear();
+    for (std::uint32_t i = 0; i < lights.size(); ++i) {
+        const glm::vec3 center(view * glm::vec4(glm::vec3(lights[i].position), 1.0f));
+        const float radius = lights[i].position.w;
+        const float depth = -center.z;
+        if (radius <= 0.0f || depth + radius < near || depth - radius > far) continue;
+
+        LightBounds bounds{i, {0, 0, to_slice(std::max(depth - radius, near))},
+                           {kClusterTilesX - 1, kClusterTilesY - 1, to_slice(std::min(depth + radius, far))}};
+        if (depth - radius > near) {
+            glm::vec2 ndc_min(std::numeric_limits<float>::max()), ndc_max(-std::numeric_limits<float>::max());
+            for (int corner = 0; corner < 8; ++corner) {
+                const glm::vec3 offset(corner & 1 ? radius : -radius, corner & 2 ? radius : -radius,
+                                       corner & 4 ? radius : -radius);
+                const glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndc_min = glm::min(ndc_min, ndc);
+                ndc_max = glm::max(ndc_max, ndc);
+            }
+            if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f) continue;
+            bounds.min.x = ToTile(ndc_min.x, kClusterTilesX);
+            bounds.max.x = ToTile(ndc_max.x, kClusterTilesX);
+            bounds.min.y = ToTile(ndc_min.y, kClusterTilesY);
+            bounds.max.y = ToTile(ndc_max.y, kClusterTilesY);
+        }
+        bounds_.push_back(bounds);
+    }
+
+    // Counting sort: count per cluster, turn counts into offsets, then fill.
+    for (glm::uvec2 &range: ranges_) range = {0, 0};
+    for (const LightBounds &bounds: bounds_)
+        for (std::uint32_t z = bounds.min.z; z <= bounds.max.z; ++z)
+            for (std::uint32_t y = bounds.min.y; y <= bounds.max.y; ++y)
+                for (std::uint32_t x = bounds.min.x; x <= bounds.max.x; ++x)
+                    ranges_[ClusterIndex(x, y, z)].y++;
+
+    std::uint32_t offset = 0;
+    for (glm::uvec2 &range: ranges_) {
+        range.x = offset;
+        offset += range.y;
+        range.y = 0;
+    }
+
+    indices_.resize(offset);
+    for (const LightBounds &bounds: bounds_)
+        for (std::uint32_t z = bounds.min.z; z <= bounds.max.z; ++z)
+            for (std::uint32_t y = bounds.min.y; y <= bounds.max.y; ++y)
+                for (std::uint32_t x = bounds.min.x; x <= bounds.max.x; ++x) {
+                    glm::uvec2 &range = ranges_[ClusterIndex(x, y, z)];
+                    indices_[range.x + range.y++] = bounds.light;
+                }
+}
@@ -0,0 +1,52 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <GlobalLight.h>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Froxel grid: screen tiles, each split into depth slices that grow
+// exponentially with view distance.
+constexpr std::uint32_t kClusterTilesX = 16;
+constexpr std::uint32_t kClusterTilesY = 9;
+constexpr std::uint32_t kClusterSlices = 24;
+constexpr std::uint32_t kClusterCount = kClusterTilesX * kClusterTilesY * kClusterSlices;
+
+// Start of the cluster buffer, followed by the ranges. Matches ClusterGrid
+// in basic_lighting.glsl (std430).
+struct ClusterGridHeader {
+    glm::uvec4 dims{};   // tiles x, tiles y, depth slices, light count
+    glm::vec4 slicing{}; // slice scale, slice bias, tile size in pixels
+};
+
+/// CPU light assignment for clustered forward shading. Each cluster gets the
+/// lights whose range overlaps it, so a fragment only loops over the lights
+/// near it instead of every light in the scene.
+class LightClusters {
+public:
+    void Build(std::span<const LightUBO> lights, const glm::mat4 &view, const glm::mat4 &projection,
+               glm::vec2 extent);
+
+    [[nodiscard]] const ClusterGridHeader &GetHeader() const { return header_; }
+    /// Per cluster, the offset of its first light in GetIndices and the count.
+    [[nodiscard]] std::span<const glm::uvec2> GetRanges() const { return ranges_; }
+    [[nodiscard]] std::span<const std::uint32_t> GetIndices() const { return indices_; }
+
+private:
+    // Inclusive cluster bounds of one light.
+    struct LightBounds {
+        std::uint32_t light;
+        glm::uvec3 min;
+        glm::uvec3 max;
+    };
+
+    ClusterGridHeader header_;
+    std::vector<glm::uvec2> ranges_ = std::vector<glm::uvec2>(kClusterCount);
+    std::vector<std::uint32_t> indices_;
+    std::vector<LightBounds> bounds_;
+};
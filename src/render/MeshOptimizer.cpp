@@ -0,0 +1,210 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/MeshOptimizer.h>
+
+#include <algorithm>
+
+// Both the replay and Tipsify model the FIFO cache with insertion stamps: a
+// vertex is still cached while fewer than cache_size vertices went in after it.
+
+VertexCacheStats &VertexCacheStats::operator+=(const VertexCacheStats &other) {
+    triangles += other.triangles;
+    misses += other.misses;
+    return *this;
+}
+
+VertexCacheStats AnalyzeVertexCache(const std::span<const std::uint32_t> indices, const std::size_t vertex_count,
+                                    const std::uint32_t cache_size) {
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    std::vector<std::uint32_t> cache_stamps(vertex_count, 0);
+    std::uint32_t time = cache_size + 1;
+    for (const std::uint32_t index: indices) {
+        if (time - cache_stamps[index] <= cache_size) continue;
+        cache_stamps[index] = time++;
+        stats.misses++;
+    }
+    return stats;
+}
+
+std::vector<std::uint32_t> OptimizeVertexCache(const std::span<std::uint32_t> indices, const std::size_t vertex_count,
+                                               const std::uint32_t cache_size) {
+    std::vector<std::uint32_t> clusters;
+    const std::size_t triangle_count = indices.size() / 3;
+    if (triangle_count == 0) return clusters;
+
+    // Triangles around each vertex, packed into one array, and how many of
+    // them are still to be emitted.
+    std::vector<std::uint32_t> live(vertex_count, 0);
+    for (const std::uint32_t index: indices) live[index]++;
+    std::vector<std::uint32_t> adjacency_offsets(vertex_count + 1, 0);
+    for (std::size_t vertex = 0; vertex < vertex_count; ++vertex)
+        adjacency_offsets[vertex + 1] = adjacency_offsets[vertex] + live[vertex];
+    std::vector<std::uint32_t> adjacency(indices.size());
+    std::vector<std::uint32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+    for (std::size_t corner = 0; corner < triangle_count * 3; ++corner)
+        adjacency[fill[indices[corner]]++] = static_cast<std::uint32_t>(corner / 3);
+
+    std::vector<std::uint32_t> cache_stamps(vertex_count, 0);
+    std::uint32_t time = cache_size + 1;
+    std::vector<bool> emitted(triangle_count, false);
+    std::vector<std::uint32_t> dead_ends;
+    std::vector<std::uint32_t> candidates;
+    std::vector<std::uint32_t> output;
+    output.reserve(triangle_count * 3);
+    std::size_t cursor = 0;
+
+    // Falls back to the most recent vertex with triangles left, then to the
+    // next one in input order. Either way the cache starts over: a new cluster.
+    const auto skip_dead_end = [&]() -> std::int64_t {
+        while (!dead_ends.empty()) {
+            const std::uint32_t vertex = dead_ends.back();
+            dead_ends.pop_back();
+            if (live[vertex] > 0) return vertex;
+        }
+        for (; cursor < vertex_count; ++cursor)
+            if (live[cursor] > 0) return static_cast<std::int64_t>(cursor);
+        return -1;
+    };
+
+    std::int64_t fan = skip_dead_end();
+    clusters.push_back(0);
+    while (fan >= 0) {
+        candidates.clear();
+        for (std::uint32_t i = adjacency_offsets[fan]; i < adjacency_offsets[fan + 1]; ++i) {
+            const std::uint32_t triangle = adjacency[i];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = true;
+            for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                const std::uint32_t vertex = indices[triangle * 3 + corner];
+                output.push_back(vertex);
+                dead_ends.push_back(vertex);
+                candidates.push_back(vertex);
+                live[vertex]--;
+                if (time - cache_stamps[vertex] > cache_size) cache_stamps[vertex] = time++;
+            }
+        }
+
+        // Fan next around the oldest neighbour that stays cached while its
+        // remaining triangles go out, or any neighbour with triangles left.
+        std::int64_t next = -1;
+        std::int64_t best_priority = -1;
+        for (const std::uint32_t vertex: candidates) {
+            if (live[vertex] == 0) continue;
+            std::int64_t priority = 0;
+            if (time - cache_stamps[vertex] + 2 * live[vertex] <= cache_size) priority = time - cache_stamps[vertex];
+            if (priority > best_priority) {
+                best_priority = priority;
+                next = vertex;
+            }
+        }
+        if (next < 0) {
+            next = skip_dead_end();
+            if (next >= 0) clusters.push_back(static_cast<std::uint32_t>(output.size() / 3));
+        }
+        fan = next;
+    }
+
+    std::ranges::copy(output, indices.begin());
+    return clusters;
+}
+
+void OptimizeOverdraw(const std::span<std::uint32_t> indices, const std::span<const std::uint32_t> clusters,
+                      const std::span<const glm::vec3> positions) {
+    const std::size_t triangle_count = indices.size() / 3;
+    if (clusters.size() < 2) return;
+
+    struct Cluster {
+        std::uint32_t first;
+        std::uint32_t count;
+        glm::vec3 centroid{0.0f};
+        glm::vec3 normal{0.0f};
+        float area = 0.0f;
+        float sort_key = 0.0f;
+    };
+
+    // Area-weighted centroids and normals; a cross product is twice the
+    // triangle's area along its normal, which is all the weighting needs.
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size());
+    glm::vec3 mesh_centroid(0.0f);
+    float mesh_area = 0.0f;
+    for (std::size_t i = 0; i < clusters.size(); ++i) {
+        const std::uint32_t end =
+            i + 1 < clusters.size() ? clusters[i + 1] : static_cast<std::uint32_t>(triangle_count);
+        Cluster cluster{clusters[i], end - clusters[i]};
+        for (std::uint32_t triangle = cluster.first; triangle < end; ++triangle) {
+            const glm::vec3 &a = positions[indices[triangle * 3 + 0]];
+            const glm::vec3 &b = positions[indices[triangle * 3 + 1]];
+            const glm::vec3 &c = positions[indices[triangle * 3 + 2]];
+            const glm::vec3 cross = glm::cross(b - a, c - a);
+            const float area = glm::length(cross);
+            cluster.centroid += (a + b + c) * (area / 3.0f);
+            cluster.normal += cross;
+            cluster.area += area;
+        }
+        mesh_centroid += cluster.centroid;
+        mesh_area += cluster.area;
+        sorted.push_back(cluster);
+    }
+    if (mesh_area > 0.0f) mesh_centroid /= mesh_area;
+
+    // How far out a cluster sits along its own normal: outer shells first.
+    for (Cluster &cluster: sorted) {
+        if (cluster.area <= 0.0f || glm::length(cluster.normal) <= 0.0f) continue;
+        cluster.sort_key = glm::dot(cluster.centroid / cluster.area - mesh_centroid, glm::normalize(cluster.normal));
+    }
+    std::ranges::stable_sort(sorted, [](const Cluster &a, const Cluster &b) { return a.sort_key > b.sort_key; });
+
+    std::vector<std::uint32_t> output;
+    output.reserve(triangle_count * 3);
+    for (const Cluster &cluster: sorted)
+        output.insert(output.end(), indices.begin() + cluster.first * 3,
+                      indices.begin() + (cluster.first + cluster.count) * 3);
+    std::ranges::copy(output, indices.begin());
+}
+
+std::vector<std::uint32_t> OptimizeVertexFetch(const std::span<std::uint32_t> indices, const std::size_t vertex_count) {
+    std::vector<std::uint32_t> remap(vertex_count, kUnusedVertex);
+    std::uint32_t next = 0;
+    for (std::uint32_t &index: indices) {
+        if (remap[index] == kUnusedVertex) remap[index] = next++;
+        index = remap[index];
+    }
+    return remap;
+}
+
+std::vector<IndexChunk> SplitIndexChunks(const std::span<std::uint32_t> indices, const std::uint32_t max_vertices) {
+    std::vector<IndexChunk> chunks;
+    const std::size_t triangle_count = indices.size() / 3;
+    std::size_t first_triangle = 0;
+    std::uint32_t low = ~0u;
+    std::uint32_t high = 0;
+    const auto close_chunk = [&](const std::size_t end_triangle) {
+        chunks.push_back({static_cast<std::uint32_t>(first_triangle * 3),
+                          static_cast<std::uint32_t>((end_triangle - first_triangle) * 3), low});
+    };
+
+    for (std::size_t triangle = 0; triangle < triangle_count; ++triangle) {
+        const auto [triangle_low, triangle_high] =
+            std::minmax({indices[triangle * 3 + 0], indices[triangle * 3 + 1], indices[triangle * 3 + 2]});
+        if (triangle > first_triangle && std::max(high, triangle_high) - std::min(low, triangle_low) >= max_vertices) {
+            close_chunk(triangle);
+            first_triangle = triangle;
+            low = triangle_low;
+            high = triangle_high;
+            continue;
+        }
+        low = std::min(low, triangle_low);
+        high = std::max(high, triangle_high);
+    }
+    if (triangle_count > first_triangle) close_chunk(triangle_count);
+
+    for (const IndexChunk &chunk: chunks)
+        for (std::uint32_t i = chunk.first_index; i < chunk.first_index + chunk.index_count; ++i)
+            indices[i] -= chunk.base_vertex;
+    return chunks;
+}
@@ -0,0 +1,70 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Entries of the FIFO post-transform cache the optimizer targets and the
+// statistics replay. Real GPUs differ; 16 is a common middle ground.
+constexpr std::uint32_t kVertexCacheSize = 16;
+
+// Post-transform cache misses of an index list.
+struct VertexCacheStats {
+    std::uint64_t triangles = 0;
+    std::uint64_t misses = 0;
+
+    /// Average cache miss ratio: vertices shaded per triangle, 0.5 at best and 3 at worst.
+    [[nodiscard]] float GetAcmr() const {
+        return triangles == 0 ? 0.0f : static_cast<float>(misses) / static_cast<float>(triangles);
+    }
+
+    VertexCacheStats &operator+=(const VertexCacheStats &other);
+};
+
+/// Replays the indices through a FIFO cache of cache_size vertices.
+VertexCacheStats AnalyzeVertexCache(std::span<const std::uint32_t> indices, std::size_t vertex_count,
+                                    std::uint32_t cache_size = kVertexCacheSize);
+
+/// Reorders the triangles for the post-transform cache with Tipsify (Sander
+/// et al. 2007): fans around the last vertices used, and only jumps elsewhere
+/// at dead ends. Returns the first triangle of each cluster the jumps split
+/// the new order into, for OptimizeOverdraw.
+std::vector<std::uint32_t> OptimizeVertexCache(std::span<std::uint32_t> indices, std::size_t vertex_count,
+                                               std::uint32_t cache_size = kVertexCacheSize);
+
+/// Sorts the clusters so the ones facing out of the mesh draw first and
+/// occlude the rest, whatever the view. Triangles keep their order inside a
+/// cluster, so the cache locality OptimizeVertexCache found stays.
+void OptimizeOverdraw(std::span<std::uint32_t> indices, std::span<const std::uint32_t> clusters,
+                      std::span<const glm::vec3> positions);
+
+constexpr std::uint32_t kUnusedVertex = ~0u;
+
+/// Renumbers vertices in the order the indices first use them, so vertex
+/// fetches walk the buffer forwards. Rewrites the indices and returns each old
+/// vertex's new index; vertices no index uses map to kUnusedVertex.
+std::vector<std::uint32_t> OptimizeVertexFetch(std::span<std::uint32_t> indices, std::size_t vertex_count);
+
+// Vertices a chunk can reach with 16-bit indices.
+constexpr std::uint32_t kMaxChunkVertices = 1u << 16;
+
+// A run of triangles drawn with its indices relative to base_vertex.
+struct IndexChunk {
+    std::uint32_t first_index = 0;
+    std::uint32_t index_count = 0;
+    std::uint32_t base_vertex = 0;
+};
+
+/// Splits the triangles into runs spanning at most max_vertices vertices and
+/// rebases each run on its lowest vertex, so they fit 16-bit indices drawn
+/// with a vertex offset. Vertices are not duplicated; after
+/// OptimizeVertexFetch the spans are tight and most meshes stay one chunk.
+/// A single triangle wider than max_vertices stays wider.
+std::vector<IndexChunk> SplitIndexChunks(std::span<std::uint32_t> indices,
+                                         std::uint32_t max_vertices = kMaxChunkVertices);
@@ -0,0 +1,427 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/RenderGraph.h>
+
+#include <algorithm>
+#include <ranges>
+#include <stdexcept>
+
+namespace {
+    struct AccessInfo {
+        VkImageLayout layout;
+        VkPipelineStageFlags2 stages;
+        VkAccessFlags2 access;
+        VkImageUsageFlags usage;
+    };
+
+    AccessInfo GetAccessInfo(const RenderGraphAccess access, const bool write, const RenderGraphPassType type) {
+        const VkPipelineStageFlags2 shader_stage = type == RenderGraphPassType::Compute
+                                                       ? VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT
+                                                       : VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+        switch (access) {
+            case RenderGraphAccess::Sampled:
+                return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, shader_stage, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT,
+                        VK_IMAGE_USAGE_SAMPLED_BIT};
+            case RenderGraphAccess::StorageRead:
+                return {VK_IMAGE_LAYOUT_GENERAL, shader_stage, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+                        VK_IMAGE_USAGE_STORAGE_BIT};
+            case RenderGraphAccess::StorageWrite:
+                return {VK_IMAGE_LAYOUT_GENERAL, shader_stage, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+                        VK_IMAGE_USAGE_STORAGE_BIT};
+            case RenderGraphAccess::ColorAttachment:
+                return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+                        write
+                            ? VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+                            : VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT,
+                        VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT};
+            case RenderGraphAccess::DepthAttachment:
+                return {write
+                            ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+                            : VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+                        VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+                        write
+                            ? VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                              VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+                            : VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+                        VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+            case RenderGraphAccess::TransferSrc:
+                return {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_READ_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT};
+            case RenderGraphAccess::TransferDst:
+                return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT,
+                        VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+        }
+        return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, VK_ACCESS_2_NONE, 0};
+    }
+
+    // What happened to an image since its last write, while planning barriers.
+    struct TrackedState {
+        VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        VkPipelineStageFlags2 write_stages = VK_PIPELINE_STAGE_2_NONE;
+        VkAccessFlags2 write_access = VK_ACCESS_2_NONE;
+        /// Stages that read since the last write; a new write must wait on them.
+        VkPipelineStageFlags2 read_stages = VK_PIPELINE_STAGE_2_NONE;
+        /// Stages the last write has already been made visible to.
+        VkPipelineStageFlags2 visible_stages = VK_PIPELINE_STAGE_2_NONE;
+        /// The next barrier still has to take ownership from another queue.
+        bool acquire = false;
+    };
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::Read(const RenderGraphResource resource,
+                                                         const RenderGraphAccess access) {
+    graph_.passes_[pass_].uses.push_back({resource, access, false});
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::Write(const RenderGraphResource resource,
+                                                          const RenderGraphAccess access) {
+    graph_.passes_[pass_].uses.push_back({resource, access, true});
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::SideEffect() {
+    graph_.passes_[pass_].side_effect = true;
+    return *this;
+}
+
+RenderGraph::PassBuilder &RenderGraph::PassBuilder::Execute(ExecuteFunction execute) {
+    graph_.passes_[pass_].execute = std::move(execute);
+    return *this;
+}
+
+RenderGraph::~RenderGraph() {
+    Destroy();
+}
+
+RenderGraphResource RenderGraph::ImportImage(const std::string &name, VkImage image, VkImageView view,
+                                             const RenderGraphImageDesc &desc, const RenderGraphImageState &state,
+                                             const std::uint32_t src_queue_family,
+                                             const std::uint32_t dst_queue_family) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = true;
+    resource.initial_state = state;
+    resource.acquire_src_queue_family = src_queue_family;
+    resource.acquire_dst_queue_family = dst_queue_family;
+    resource.image = image;
+    resource.view = view;
+    resources_.push_back(std::move(resource));
+    return static_cast<RenderGraphResource>(resources_.size() - 1);
+}
+
+RenderGraphResource RenderGraph::CreateImage(const std::string &name, const RenderGraphImageDesc &desc) {
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources_.push_back(std::move(resource));
+    return static_cast<RenderGraphResource>(resources_.size() - 1);
+}
+
+void RenderGraph::ExportImage(const RenderGraphResource resource, const RenderGraphImageState &state,
+                              const std::uint32_t src_queue_family, const std::uint32_t dst_queue_family) {
+    Resource &exported = resources_[resource];
+    exported.exported = true;
+    exported.final_state = state;
+    exported.src_queue_family = src_queue_family;
+    exported.dst_queue_family = dst_queue_family;
+}
+
+RenderGraph::PassBuilder RenderGraph::AddPass(const std::string &name, const RenderGraphPassType type) {
+    Pass pass;
+    pass.name = name;
+    pass.type = type;
+    passes_.push_back(std::move(pass));
+    return {*this, static_cast<std::uint32_t>(passes_.size() - 1)};
+}
+
+void RenderGraph::Compile(VkDevice device, const RenderGraphAllocator &allocator, const bool synchronization2) {
+    device_ = device;
+    allocator_ = allocator;
+    synchronization2_ = synchronization2;
+
+    CullPasses();
+    CreateTransients();
+    PlanBarriers();
+    compiled_ = true;
+}
+
+std::size_t RenderGraph::GetTransientImageCount() const {
+    return static_cast<std::size_t>(std::ranges::count_if(resources_, [](const Resource &resource) {
+        return !resource.imported && resource.image != VK_NULL_HANDLE;
+    }));
+}
+
+void RenderGraph::CullPasses() {
+    // Walk backwards from what leaves the graph: a pass survives if a later
+    // surviving pass reads what it writes, or it writes outside the graph.
+    std::vector<bool> needed(resources_.size());
+    for (std::size_t i = 0; i < resources_.size(); ++i)
+        needed[i] = resources_[i].imported || resources_[i].exported;
+
+    culled_passes_ = 0;
+    for (Pass &pass: passes_ | std::views::reverse) {
+        const bool alive = pass.side_effect || std::ranges::any_of(pass.uses, [&needed](const ResourceUse &use) {
+            return use.write && needed[use.resource];
+        });
+        if (!alive) {
+            pass.culled = true;
+            ++culled_passes_;
+            continue;
+        }
+        for (const ResourceUse &use: pass.uses)
+            if (!use.write) needed[use.resource] = true;
+    }
+
+    for (std::size_t i = 0; i < passes_.size(); ++i) {
+        if (passes_[i].culled) continue;
+        for (const ResourceUse &use: passes_[i].uses) {
+            Resource &resource = resources_[use.resource];
+            if (resource.first_pass < 0) resource.first_pass = static_cast<std::int32_t>(i);
+            resource.last_pass = static_cast<std::int32_t>(i);
+            resource.usage |= GetAccessInfo(use.access, use.write, passes_[i].type).usage;
+        }
+    }
+
+    // An exported image is read after the graph, so it lives to the end of it
+    // and nothing first used after its last pass may take its memory.
+    for (Resource &resource: resources_)
+        if (resource.exported && resource.first_pass >= 0)
+            resource.last_pass = static_cast<std::int32_t>(passes_.size());
+}
+
+void RenderGraph::CreateTransients() {
+    struct Block {
+        VkDeviceSize size;
+        std::uint32_t memory_type;
+        std::vector<RenderGraphResource> occupants;
+    };
+
+    std::vector<RenderGraphResource> transients;
+    std::vector<VkMemoryRequirements> requirements(resources_.size());
+    for (RenderGraphResource i = 0; i < resources_.size(); ++i) {
+        Resource &resource = resources_[i];
+        if (resource.imported || resource.first_pass < 0) continue;
+
+        VkImageCreateInfo image_info{};
+        image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        image_info.imageType = VK_IMAGE_TYPE_2D;
+        image_info.format = resource.desc.format;
+        image_info.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+        image_info.mipLevels = 1;
+        image_info.arrayLayers = resource.desc.layers;
+        image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+        image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        image_info.usage = resource.usage;
+        image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if (vkCreateImage(device_, &image_info, nullptr, &resource.image) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create render graph image " + resource.name);
+        }
+        vkGetImageMemoryRequirements(device_, resource.image, &requirements[i]);
+        transients.push_back(i);
+    }
+
+    // Largest first, each into the first block of the same memory type whose
+    // occupants are all dead before it is born or born after it dies. Every
+    // occupant sits at offset zero, so alignment never needs adjusting.
+    std::ranges::sort(transients, std::greater{}, [&requirements](RenderGraphResource i) {
+        return requirements[i].size;
+    });
+
+    std::vector<Block> blocks;
+    for (const RenderGraphResource i: transients) {
+        const Resource &resource = resources_[i];
+        const std::uint32_t memory_type = allocator_.find_memory_type(requirements[i].memoryTypeBits);
+        unaliased_bytes_ += requirements[i].size;
+
+        const auto fits = [&](const Block &block) {
+            return block.memory_type == memory_type && block.size >= requirements[i].size &&
+                   std::ranges::none_of(block.occupants, [&](RenderGraphResource other) {
+                       return resources_[other].first_pass <= resource.last_pass &&
+                              resource.first_pass <= resources_[other].last_pass;
+                   });
+        };
+        if (const auto block = std::ranges::find_if(blocks, fits); block != blocks.end())
+            block->occupants.push_back(i);
+        else
+            blocks.push_back({requirements[i].size, memory_type, {i}});
+    }
+
+    for (Block &block: blocks) {
+        VkDeviceMemory memory = allocator_.allocate(block.size, block.memory_type);
+        if (memory == VK_NULL_HANDLE) {
+            throw std::runtime_error("Failed to allocate render graph memory!");
+        }
+        memory_blocks_.push_back(memory);
+        transient_bytes_ += block.size;
+
+        // Each occupant inherits the memory of the one that died right before it.
+        std::ranges::sort(block.occupants, {}, [this](RenderGraphResource i) { return resources_[i].first_pass; });
+        for (std::size_t j = 0; j < block.occupants.size(); ++j) {
+            Resource &resource = resources_[block.occupants[j]];
+            if (j > 0) resource.aliases = static_cast<std::int32_t>(block.occupants[j - 1]);
+            vkBindImageMemory(device_, resource.image, memory, 0);
+
+            VkImageViewCreateInfo view_info{};
+            view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+            view_info.image = resource.image;
+            view_info.viewType = resource.desc.layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+            view_info.format = resource.desc.format;
+            view_info.subresourceRange = {resource.desc.aspect, 0, 1, 0, resource.desc.layers};
+
+            if (vkCreateImageView(device_, &view_info, nullptr, &resource.view) != VK_SUCCESS) {
+                throw std::runtime_error("Failed to create render graph image view " + resource.name);
+            }
+        }
+    }
+}
+
+void RenderGraph::PlanBarriers() {
+    std::vector<TrackedState> states(resources_.size());
+    for (std::size_t i = 0; i < resources_.size(); ++i) {
+        const Resource &resource = resources_[i];
+        if (!resource.imported) continue;
+        states[i].layout = resource.initial_state.layout;
+        states[i].write_access = resource.initial_state.access;
+        if (resource.initial_state.access != VK_ACCESS_2_NONE)
+            states[i].write_stages = resource.initial_state.stages;
+        else
+            states[i].read_stages = resource.initial_state.stages;
+        states[i].acquire = resource.acquire_src_queue_family != resource.acquire_dst_queue_family;
+    }
+
+    for (std::size_t pass_index = 0; pass_index < passes_.size(); ++pass_index) {
+        Pass &pass = passes_[pass_index];
+        if (pass.culled) continue;
+
+        for (const ResourceUse &use: pass.uses) {
+            const Resource &resource = resources_[use.resource];
+            const AccessInfo info = GetAccessInfo(use.access, use.write, pass.type);
+            TrackedState &state = states[use.resource];
+
+            VkPipelineStageFlags2 src_stages = VK_PIPELINE_STAGE_2_NONE;
+            VkAccessFlags2 src_access = VK_ACCESS_2_NONE;
+            VkImageLayout old_layout = state.layout;
+            const bool first_use = !resource.imported && resource.first_pass == static_cast<std::int32_t>(pass_index);
+            if (first_use) {
+                // Contents are undefined, but whatever used the memory before
+                // has to be done with it.
+                old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                if (resource.aliases >= 0) {
+                    const TrackedState &previous = states[resource.aliases];
+                    src_stages = previous.write_stages | previous.read_stages;
+                    src_access = previous.write_access;
+                }
+            } else if (use.write || old_layout != info.layout) {
+                // Write after write and write after read. A read that changes
+                // the layout counts too: the transition writes the image.
+                src_stages = state.write_stages | state.read_stages;
+                src_access = state.write_access;
+            } else if (state.write_stages != 0 && (info.stages & ~state.visible_stages) != 0) {
+                // Read after write.
+                src_stages = state.write_stages;
+                src_access = state.write_access;
+            }
+
+            if (state.acquire) {
+                // The release on the other queue made its writes available and
+                // the semaphore between them ordered everything before it.
+                src_stages = VK_PIPELINE_STAGE_2_NONE;
+                src_access = VK_ACCESS_2_NONE;
+            }
+
+            const bool layout_change = old_layout != info.layout || first_use;
+            if (layout_change || src_stages != 0 || state.acquire) {
+                ImageBarrier barrier;
+                barrier.image = resource.image;
+                barrier.aspect = resource.desc.aspect;
+                barrier.layer_count = resource.desc.layers;
+                barrier.old_layout = old_layout;
+                barrier.new_layout = info.layout;
+                barrier.src_stages = src_stages;
+                barrier.src_access = src_access;
+                barrier.dst_stages = info.stages;
+                barrier.dst_access = info.access;
+                if (state.acquire) {
+                    barrier.src_queue_family = resource.acquire_src_queue_family;
+                    barrier.dst_queue_family = resource.acquire_dst_queue_family;
+                    state.acquire = false;
+                }
+                pass.barriers.push_back(barrier);
+            }
+
+            state.layout = info.layout;
+            if (use.write) {
+                state.write_stages = info.stages;
+                state.write_access = info.access;
+                state.read_stages = VK_PIPELINE_STAGE_2_NONE;
+                state.visible_stages = VK_PIPELINE_STAGE_2_NONE;
+            } else if (layout_change) {
+                // Only this pass's stages are known to see the transition;
+                // later barriers chain through them to reach it.
+                state.write_stages |= info.stages;
+                state.read_stages = info.stages;
+                state.visible_stages = info.stages;
+            } else {
+                state.read_stages |= info.stages;
+                state.visible_stages |= info.stages;
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < resources_.size(); ++i) {
+        const Resource &resource = resources_[i];
+        if (!resource.exported || resource.first_pass < 0) continue;
+
+        const TrackedState &state = states[i];
+        ImageBarrier barrier;
+        barrier.image = resource.image;
+        barrier.aspect = resource.desc.aspect;
+        barrier.layer_count = resource.desc.layers;
+        barrier.old_layout = state.layout;
+        barrier.new_layout = resource.final_state.layout;
+        barrier.src_stages = state.write_stages | state.read_stages;
+        barrier.src_access = state.write_access;
+        barrier.dst_stages = resource.final_state.stages;
+        barrier.dst_access = resource.final_state.access;
+        barrier.src_queue_family = resource.src_queue_family;
+        barrier.dst_queue_family = resource.dst_queue_family;
+        final_barriers_.push_back(barrier);
+    }
+}
+
+void RenderGraph::Execute(VkCommandBuffer command_buffer) const {
+    for (const Pass &pass: passes_) {
+        if (pass.culled) continue;
+        RecordImageBarriers(command_buffer, pass.barriers, synchronization2_);
+        if (pass.execute) pass.execute(command_buffer, *this);
+    }
+
+    RecordImageBarriers(command_buffer, final_barriers_, synchronization2_);
+}
+
+void RenderGraph::Destroy() {
+    if (device_ != VK_NULL_HANDLE) {
+        for (const Resource &resource: resources_) {
+            if (resource.imported) continue;
+            if (resource.view != VK_NULL_HANDLE) vkDestroyImageView(device_, resource.view, nullptr);
+            if (resource.image != VK_NULL_HANDLE) vkDestroyImage(device_, resource.image, nullptr);
+        }
+        for (VkDeviceMemory memory: memory_blocks_)
+            allocator_.free(memory);
+    }
+
+    passes_.clear();
+    resources_.clear();
+    memory_blocks_.clear();
+    final_barriers_.clear();
+    culled_passes_ = 0;
+    transient_bytes_ = 0;
+    unaliased_bytes_ = 0;
+    compiled_ = false;
+}
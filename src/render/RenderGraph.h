@@ -0,0 +1,181 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <render/ImageBarrier.h>
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using RenderGraphResource = std::uint32_t;
+
+enum class RenderGraphPassType : std::uint8_t {
+    Graphics,
+    Compute
+};
+
+// How a pass touches an image. Layouts, stages and access masks are derived
+// from this and the pass type, so passes never spell out synchronization.
+enum class RenderGraphAccess : std::uint8_t {
+    Sampled,
+    StorageRead,
+    StorageWrite,
+    ColorAttachment,
+    DepthAttachment,
+    TransferSrc,
+    TransferDst
+};
+
+struct RenderGraphImageDesc {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    VkExtent2D extent{};
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    /// Array layers; barriers always cover all of them.
+    std::uint32_t layers = 1;
+};
+
+// Layout and pending access of an image at the edges of the graph. Without an
+// access the stages are readers that a later write or transition must wait on.
+struct RenderGraphImageState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkPipelineStageFlags2 stages = VK_PIPELINE_STAGE_2_NONE;
+    VkAccessFlags2 access = VK_ACCESS_2_NONE;
+};
+
+// Device memory comes from the owner so it shows up in its allocation stats.
+struct RenderGraphAllocator {
+    std::function<std::uint32_t(std::uint32_t memory_type_bits)> find_memory_type;
+    std::function<VkDeviceMemory(VkDeviceSize size, std::uint32_t memory_type)> allocate;
+    std::function<void(VkDeviceMemory memory)> free;
+};
+
+/// Declarative frame graph. Passes declare the images they read and write;
+/// Compile culls passes whose results are never used, places transient images
+/// with disjoint lifetimes in the same memory and plans every barrier, and
+/// Execute records the passes with those barriers in between.
+///
+/// Graphics passes that render through a VkRenderPass must keep their
+/// attachments in the attachment layout: the graph does the transitions.
+class RenderGraph {
+public:
+    using ExecuteFunction = std::function<void(VkCommandBuffer command_buffer, const RenderGraph &graph)>;
+
+    class PassBuilder {
+    public:
+        PassBuilder &Read(RenderGraphResource resource, RenderGraphAccess access);
+        PassBuilder &Write(RenderGraphResource resource, RenderGraphAccess access);
+        /// Keeps the pass even when nothing reads what it writes.
+        PassBuilder &SideEffect();
+        PassBuilder &Execute(ExecuteFunction execute);
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph &graph, std::uint32_t pass) : graph_(graph), pass_(pass) {}
+
+        RenderGraph &graph_;
+        std::uint32_t pass_;
+    };
+
+    RenderGraph() = default;
+    ~RenderGraph();
+    RenderGraph(const RenderGraph &) = delete;
+    RenderGraph &operator=(const RenderGraph &) = delete;
+
+    /// Image owned elsewhere, in the given state when the graph starts. With
+    /// queue families, its first use acquires it from the family that released
+    /// it; the state's layout must then be the one that release started from.
+    RenderGraphResource ImportImage(const std::string &name, VkImage image, VkImageView view,
+                                    const RenderGraphImageDesc &desc, const RenderGraphImageState &state,
+                                    std::uint32_t src_queue_family = VK_QUEUE_FAMILY_IGNORED,
+                                    std::uint32_t dst_queue_family = VK_QUEUE_FAMILY_IGNORED);
+    /// Image that only lives during the graph. Its contents are undefined on
+    /// first use and it may share memory with other transients.
+    RenderGraphResource CreateImage(const std::string &name, const RenderGraphImageDesc &desc);
+    /// Leaves the image in the given state after the last pass, optionally
+    /// releasing it to another queue family. Passes writing it are never culled.
+    void ExportImage(RenderGraphResource resource, const RenderGraphImageState &state,
+                     std::uint32_t src_queue_family = VK_QUEUE_FAMILY_IGNORED,
+                     std::uint32_t dst_queue_family = VK_QUEUE_FAMILY_IGNORED);
+    PassBuilder AddPass(const std::string &name, RenderGraphPassType type);
+
+    /// Creates the transient images and plans barriers. The graph is fixed
+    /// afterwards; call Destroy before declaring a new one. Without
+    /// synchronization2 each pass's barriers share one set of stage masks.
+    void Compile(VkDevice device, const RenderGraphAllocator &allocator, bool synchronization2);
+    void Execute(VkCommandBuffer command_buffer) const;
+    /// Releases transient images and memory. Must not run while a command
+    /// buffer recorded by Execute is still in flight.
+    void Destroy();
+
+    [[nodiscard]] bool IsCompiled() const { return compiled_; }
+    [[nodiscard]] bool IsUsed(RenderGraphResource resource) const { return resources_[resource].first_pass >= 0; }
+    [[nodiscard]] VkImage GetImage(RenderGraphResource resource) const { return resources_[resource].image; }
+    [[nodiscard]] VkImageView GetView(RenderGraphResource resource) const { return resources_[resource].view; }
+    [[nodiscard]] const RenderGraphImageDesc &GetDesc(RenderGraphResource resource) const {
+        return resources_[resource].desc;
+    }
+    [[nodiscard]] std::size_t GetResourceCount() const { return resources_.size(); }
+    [[nodiscard]] std::size_t GetPassCount() const { return passes_.size(); }
+    [[nodiscard]] std::size_t GetTransientImageCount() const;
+    [[nodiscard]] std::uint32_t GetCulledPassCount() const { return culled_passes_; }
+    /// Memory actually allocated for transients, and what it would be unaliased.
+    [[nodiscard]] VkDeviceSize GetTransientBytes() const { return transient_bytes_; }
+    [[nodiscard]] VkDeviceSize GetUnaliasedBytes() const { return unaliased_bytes_; }
+
+private:
+    struct ResourceUse {
+        RenderGraphResource resource;
+        RenderGraphAccess access;
+        bool write;
+    };
+
+    struct Pass {
+        std::string name;
+        RenderGraphPassType type = RenderGraphPassType::Graphics;
+        std::vector<ResourceUse> uses;
+        ExecuteFunction execute;
+        bool side_effect = false;
+        bool culled = false;
+        std::vector<ImageBarrier> barriers;
+    };
+
+    struct Resource {
+        std::string name;
+        RenderGraphImageDesc desc;
+        bool imported = false;
+        bool exported = false;
+        RenderGraphImageState initial_state;
+        RenderGraphImageState final_state;
+        std::uint32_t acquire_src_queue_family = VK_QUEUE_FAMILY_IGNORED;
+        std::uint32_t acquire_dst_queue_family = VK_QUEUE_FAMILY_IGNORED;
+        std::uint32_t src_queue_family = VK_QUEUE_FAMILY_IGNORED;
+        std::uint32_t dst_queue_family = VK_QUEUE_FAMILY_IGNORED;
+        VkImageUsageFlags usage = 0;
+        std::int32_t first_pass = -1;
+        std::int32_t last_pass = -1;
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        /// Transient whose memory this one reuses, or -1.
+        std::int32_t aliases = -1;
+    };
+
+    void CullPasses();
+    void CreateTransients();
+    void PlanBarriers();
+
+    std::vector<Pass> passes_;
+    std::vector<Resource> resources_;
+    std::vector<VkDeviceMemory> memory_blocks_;
+    std::vector<ImageBarrier> final_barriers_;
+    VkDevice device_ = VK_NULL_HANDLE;
+    RenderGraphAllocator allocator_;
+    std::uint32_t culled_passes_ = 0;
+    VkDeviceSize transient_bytes_ = 0;
+    VkDeviceSize unaliased_bytes_ = 0;
+    bool synchronization2_ = false;
+    bool compiled_ = false;
+};
@@ -5,6 +5,8 @@
 #include <render/Scene.h>
 
 #include <components/Actor.h>
+#include <components/TransformComponent.h>
+#include <Profiler.h>
 
 Scene::Scene(Renderer *renderer_) : renderer(renderer_) {
     OnCreate();
@@ -34,9 +36,11 @@ void Scene::OnDestroy() {
 }
 
 void Scene::Render() {
+    PROFILE_FUNCTION();
     if (renderer->getRendererType() == RendererType::VULKAN) {
         VulkanRenderer *vRenderer = dynamic_cast<VulkanRenderer *>(renderer);
-        vRenderer->SetLightsUBO(global_lighting_);
+        vRenderer->SetLights(global_lighting_);
+        vRenderer->SetShadowCasterRevision(TransformComponent::GetRevision());
     }
     for (Component *component: components_) {
         component->Render();
@@ -0,0 +1,145 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#include <render/ShadowMaps.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Blend of logarithmic and uniform cascade splits; higher favours log.
+    constexpr float kCascadeSplitLambda = 0.75f;
+    // Cached cascades cover this much more than their slice needs, which is
+    // how far the camera can move before one is re-rendered.
+    constexpr float kCascadeMargin = 0.25f;
+    // Distance towards the sun past a cascade's sphere that still casts into it.
+    constexpr float kCasterReach = 100.0f;
+    constexpr float kPointShadowNear = 0.05f;
+
+#if GLM_CONFIG_CLIP_CONTROL & GLM_CLIP_CONTROL_ZO_BIT
+    constexpr float kNearNdcDepth = 0.0f;
+#else
+    constexpr float kNearNdcDepth = -1.0f;
+#endif
+
+    glm::vec3 StableUp(const glm::vec3 &direction) {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+void ShadowCache::Update(const DirectionalLight &sun, const std::span<const LightUBO> shadowed_lights,
+                         const glm::mat4 &view, const glm::mat4 &projection, const std::uint64_t caster_revision) {
+    if (caster_revision != caster_revision_) {
+        caster_revision_ = caster_revision;
+        for (ShadowView &shadow_view: views_)
+            shadow_view.dirty |= shadow_view.active;
+    }
+
+    UpdateCascades(sun, view, projection);
+    for (std::uint32_t slot = 0; slot < kMaxShadowedPointLights; ++slot)
+        UpdatePointLight(slot, slot < shadowed_lights.size() ? &shadowed_lights[slot] : nullptr);
+}
+
+void ShadowCache::MarkRendered() {
+    for (ShadowView &shadow_view: views_)
+        shadow_view.dirty = false;
+}
+
+void ShadowCache::UpdateCascades(const DirectionalLight &sun, const glm::mat4 &view, const glm::mat4 &projection) {
+    uniforms_.sun_direction = sun.direction;
+    uniforms_.sun_diffuse = sun.diffuse;
+    if (sun.direction.w == 0.0f) {
+        for (std::uint32_t cascade = 0; cascade < kShadowCascades; ++cascade)
+            views_[cascade].active = false;
+        uniforms_.cascade_far = glm::vec4(0.0f);
+        return;
+    }
+
+    const float near = projection[3][2] / (kNearNdcDepth + projection[2][2]);
+    const float far = std::min(projection[3][2] / (1.0f + projection[2][2]), kShadowDistance);
+    const glm::vec2 tan_half_fov(1.0f / projection[0][0], 1.0f / projection[1][1]);
+    const glm::mat4 camera_to_world = glm::inverse(view);
+    const glm::vec3 direction = glm::normalize(glm::vec3(sun.direction));
+
+    float slice_near = near;
+    for (std::uint32_t cascade = 0; cascade < kShadowCascades; ++cascade) {
+        const float t = static_cast<float>(cascade + 1) / kShadowCascades;
+        const float slice_far = kCascadeSplitLambda * near * std::pow(far / near, t) +
+                                (1.0f - kCascadeSplitLambda) * (near + (far - near) * t);
+        uniforms_.cascade_far[cascade] = slice_far;
+
+        // Bounding sphere of the frustum slice. Its radius does not depend
+        // on where the camera looks, only the center does.
+        std::array<glm::vec3, 8> corners;
+        glm::vec3 center(0.0f);
+        for (std::uint32_t corner = 0; corner < corners.size(); ++corner) {
+            const float depth = corner & 4 ? slice_far : slice_near;
+            const glm::vec2 xy = tan_half_fov * depth * glm::vec2(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f);
+            corners[corner] = glm::vec3(camera_to_world * glm::vec4(xy, -depth, 1.0f));
+            center += corners[corner] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3 &corner: corners)
+            radius = std::max(radius, glm::length(corner - center));
+        slice_near = slice_far;
+
+        ShadowView &shadow_view = views_[cascade];
+        CachedFit &fit = fits_[cascade];
+        const bool covered = shadow_view.active && fit.light == sun.direction &&
+                             glm::length(center - fit.center) + radius <= fit.radius;
+        if (covered) continue;
+
+        // Snap the center to whole texels in light space so a re-fit moves
+        // the map by texels instead of resampling every edge.
+        fit = {sun.direction, center, radius * (1.0f + kCascadeMargin)};
+        const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), direction, StableUp(direction));
+        const float texel = 2.0f * fit.radius / kCascadeShadowSize;
+        glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+        light_center.x = std::floor(light_center.x / texel) * texel;
+        light_center.y = std::floor(light_center.y / texel) * texel;
+        const glm::vec3 snapped = glm::vec3(glm::inverse(light_view) * glm::vec4(light_center, 1.0f));
+
+        const glm::vec3 eye = snapped - direction * (fit.radius + kCasterReach);
+        shadow_view.view_proj = glm::orthoRH_ZO(-fit.radius, fit.radius, -fit.radius, fit.radius, 0.0f,
+                                                2.0f * fit.radius + kCasterReach) *
+                                glm::lookAt(eye, snapped, StableUp(direction));
+        shadow_view.active = true;
+        shadow_view.dirty = true;
+        uniforms_.cascade_view_proj[cascade] = shadow_view.view_proj;
+    }
+}
+
+void ShadowCache::UpdatePointLight(const std::uint32_t slot, const LightUBO *light) {
+    const std::uint32_t first_view = kShadowCascades + slot * kCubeFaces;
+    if (light == nullptr) {
+        for (std::uint32_t face = 0; face < kCubeFaces; ++face)
+            views_[first_view + face].active = false;
+        return;
+    }
+
+    CachedFit &fit = fits_[first_view];
+    if (views_[first_view].active && fit.light == light->position) return;
+    fit.light = light->position;
+
+    // +X, -X, +Y, -Y, +Z, -Z, the order basic_lighting.glsl picks faces in.
+    static const std::array<glm::vec3, kCubeFaces> kFaceDirections = {
+        glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+        glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f)
+    };
+    // A few texels wider than 90 degrees, so filtering at a face edge stays inside the face.
+    const float fov = 2.0f * std::atan(1.0f + 4.0f / kPointShadowSize);
+    const glm::mat4 face_projection = glm::perspectiveRH_ZO(fov, 1.0f, kPointShadowNear,
+                                                            std::max(light->position.w, 2.0f * kPointShadowNear));
+    const glm::vec3 position(light->position);
+    for (std::uint32_t face = 0; face < kCubeFaces; ++face) {
+        ShadowView &shadow_view = views_[first_view + face];
+        shadow_view.view_proj = face_projection * glm::lookAt(position, position + kFaceDirections[face],
+                                                              StableUp(kFaceDirections[face]));
+        shadow_view.active = true;
+        shadow_view.dirty = true;
+        uniforms_.point_view_proj[slot * kCubeFaces + face] = shadow_view.view_proj;
+    }
+}
@@ -0,0 +1,77 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#pragma once
+
+#include <GlobalLight.h>
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// The sun gets cascades in one layered map; point lights flagged as shadow
+// casters get six faces each in another, sampled as a plain array rather
+// than a cube so both maps share one lookup path.
+constexpr std::uint32_t kShadowCascades = 4;
+constexpr std::uint32_t kMaxShadowedPointLights = 4;
+constexpr std::uint32_t kCubeFaces = 6;
+constexpr std::uint32_t kPointShadowLayers = kMaxShadowedPointLights * kCubeFaces;
+constexpr std::uint32_t kShadowViewCount = kShadowCascades + kPointShadowLayers;
+constexpr std::uint32_t kCascadeShadowSize = 2048;
+constexpr std::uint32_t kPointShadowSize = 512;
+// Cascades stop at this view depth; farther fragments are unshadowed.
+constexpr float kShadowDistance = 150.0f;
+
+// Matches ShadowData in basic_lighting.glsl (std140). The sun is kept here
+// as it is the only light that is not in the clustered list.
+struct ShadowUniforms {
+    glm::mat4 cascade_view_proj[kShadowCascades]{};
+    glm::mat4 point_view_proj[kPointShadowLayers]{};
+    glm::vec4 cascade_far{0.0f}; // view depth each cascade reaches
+    glm::vec4 sun_direction{0.0f};
+    glm::vec4 sun_diffuse{0.0f};
+};
+
+// One layer of a shadow map: cascades 0..kShadowCascades-1 of the sun, then
+// kCubeFaces per point light slot.
+struct ShadowView {
+    glm::mat4 view_proj{1.0f};
+    /// Needs rendering this frame: never rendered, or what it shows changed.
+    bool dirty = true;
+    /// Has a light; inactive views are only cleared.
+    bool active = false;
+};
+
+/// Keeps shadow views valid across frames and flags the few that must be
+/// re-rendered. Depth is cached until a shadow caster moves (the caster
+/// revision changes) or the view's light does. Cascades cover a sphere a
+/// bit larger than their slice of the camera frustum, so they also survive
+/// camera rotation and small camera moves.
+class ShadowCache {
+public:
+    /// shadowed_lights are the point lights with a slot, at most kMaxShadowedPointLights.
+    void Update(const DirectionalLight &sun, std::span<const LightUBO> shadowed_lights, const glm::mat4 &view,
+                const glm::mat4 &projection, std::uint64_t caster_revision);
+    /// Call once the dirty views have been recorded.
+    void MarkRendered();
+
+    [[nodiscard]] std::span<const ShadowView> GetViews() const { return views_; }
+    [[nodiscard]] const ShadowUniforms &GetUniforms() const { return uniforms_; }
+
+private:
+    // What a view was rendered for; a view is reused while this still holds.
+    struct CachedFit {
+        glm::vec4 light{0.0f};
+        glm::vec3 center{0.0f};
+        float radius = 0.0f;
+    };
+
+    void UpdateCascades(const DirectionalLight &sun, const glm::mat4 &view, const glm::mat4 &projection);
+    void UpdatePointLight(std::uint32_t slot, const LightUBO *light);
+
+    std::array<ShadowView, kShadowViewCount> views_{};
+    std::array<CachedFit, kShadowViewCount> fits_{};
+    ShadowUniforms uniforms_;
+    std::uint64_t caster_revision_ = 0;
+};
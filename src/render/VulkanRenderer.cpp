@@ -8,7 +8,13 @@
 #include <Utilities.h>
 
 #include <CameraPosition.h>
+#include <Profiler.h>
 #include <UniformTransformations.h>
+#include <render/ImageBarrier.h>
+
+#include <cstring>
+#include <limits>
+#include <ranges>
 
 VKAPI_ATTR VkResult VKAPI_CALL vkCreateDebugUtilsMessengerEXT(VkInstance instance,
                                                               const VkDebugUtilsMessengerCreateInfoEXT *pCreateInfo,
@@ -136,7 +142,8 @@ std::vector<const char *> VulkanRenderer::GetSuggestedInstanceExtensions() {
 }
 
 std::vector<const char *> VulkanRenderer::GetRequiredInstanceExtensions() const {
-    std::vector<const char *> suggested_extensions = GetSuggestedInstanceExtensions();
+    std::vector<const char *> suggested_extensions;
+    if (!headless_) suggested_extensions = GetSuggestedInstanceExtensions();
     std::vector<const char *> required_extensions(suggested_extensions.size());
     std::ranges::copy(suggested_extensions, required_extensions.begin());
 
@@ -159,7 +166,7 @@ void VulkanRenderer::CreateInstance() {
     std::vector<const char *> requiredExtensions = GetRequiredInstanceExtensions();
     VkApplicationInfo app_info = {
         VK_STRUCTURE_TYPE_APPLICATION_INFO, nullptr, "Vulkan Project", VK_MAKE_VERSION(0, 0, 1), "Mixed Engine",
-        VK_MAKE_VERSION(0, 0, 1), VK_API_VERSION_1_2
+        VK_MAKE_VERSION(0, 0, 1), VK_API_VERSION_1_3
     };
 
     VkDebugUtilsMessengerCreateInfoEXT debug_create_info = GetCreateDebugMessengerInfo();
@@ -186,6 +193,8 @@ void VulkanRenderer::CreateInstance() {
 }
 
 void VulkanRenderer::CreateSurface() {
+    if (headless_) return;
+
     VkResult result = glfwCreateWindowSurface(vk_instance_, window->getGLFWwindow(), nullptr, &vk_surface_);
     if (result != VK_SUCCESS) {
         spdlog::error("Failed to create window surface!");
@@ -205,8 +214,21 @@ QueueFamilyIndices VulkanRenderer::FindQueueFamilies(VkPhysicalDevice device) co
     });
 
     QueueFamilyIndices indices;
+    if (graphics_family_it == queue_families.end()) return indices;
     indices.graphicsFamily = graphics_family_it - queue_families.begin();
 
+    auto compute_family_it = std::ranges::find_if(queue_families, [](const VkQueueFamilyProperties &props) {
+        return (props.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(props.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+    });
+    if (compute_family_it != queue_families.end())
+        indices.computeFamily = compute_family_it - queue_families.begin();
+
+    // Nothing is presented in headless mode.
+    if (headless_) {
+        indices.presentFamily = indices.graphicsFamily;
+        return indices;
+    }
+
     for (std::uint32_t i = 0; i < queue_families.size(); ++i) {
         VkBool32 present_support = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, vk_surface_, &present_support);
@@ -254,15 +276,22 @@ bool IsDeviceExtensionWithinList(const std::vector<VkExtensionProperties> &exten
     });
 }
 
-bool VulkanRenderer::AreAllDeviceExtensionsSupported(VkPhysicalDevice device) {
+std::vector<const char *> VulkanRenderer::GetRequiredDeviceExtensions() const {
+    if (headless_) return {};
+    return deviceExtensions;
+}
+
+bool VulkanRenderer::AreAllDeviceExtensionsSupported(VkPhysicalDevice device) const {
     std::vector<VkExtensionProperties> extensions = GetDeviceAvailableExtensions(device);
-    return std::ranges::all_of(deviceExtensions, std::bind_front(IsDeviceExtensionWithinList, extensions));
+    return std::ranges::all_of(GetRequiredDeviceExtensions(),
+                               std::bind_front(IsDeviceExtensionWithinList, extensions));
 }
 
 bool VulkanRenderer::IsDeviceSuitable(VkPhysicalDevice device) const {
     const QueueFamilyIndices indices = FindQueueFamilies(device);
 
-    return indices.isComplete() && AreAllDeviceExtensionsSupported(device) && FindSwapChainSupport(device).IsValid();
+    if (!indices.isComplete() || !AreAllDeviceExtensionsSupported(device)) return false;
+    return headless_ || FindSwapChainSupport(device).IsValid();
 }
 
 std::vector<VkPhysicalDevice> VulkanRenderer::GetPhysicalDevices() const {
@@ -287,6 +316,11 @@ void VulkanRenderer::PickPhysicalDevice() {
     }
 
     vk_physical_device_ = devices[0];
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(vk_physical_device_, &properties);
+    spdlog::info("Using physical device {} (type {})", properties.deviceName,
+                 static_cast<int>(properties.deviceType));
 }
 
 void VulkanRenderer::CreateLogicalDeviceAndQueues() {
@@ -298,6 +332,7 @@ void VulkanRenderer::CreateLogicalDeviceAndQueues() {
     }
 
     std::set uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    if (indices.computeFamily) uniqueQueueFamilies.insert(indices.computeFamily.value());
 
     std::float_t priority = 1.0f;
 
@@ -310,16 +345,69 @@ void VulkanRenderer::CreateLogicalDeviceAndQueues() {
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Only ask for what the device has; software rasterizers do not
+    // necessarily expose depth bounds.
+    VkPhysicalDeviceFeatures available_features = {};
+    vkGetPhysicalDeviceFeatures(vk_physical_device_, &available_features);
+
     VkPhysicalDeviceFeatures required_features = {};
-    required_features.depthBounds = true;
-    required_features.depthClamp = true;
+    required_features.depthBounds = available_features.depthBounds;
+    required_features.depthClamp = available_features.depthClamp;
+
+    // Dynamic rendering and synchronization2 are core in 1.3; older devices
+    // keep render passes and legacy barriers.
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(vk_physical_device_, &properties);
+
+    VkPhysicalDeviceVulkan13Features available_13_features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES
+    };
+    if (properties.apiVersion >= VK_API_VERSION_1_3) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &available_13_features};
+        vkGetPhysicalDeviceFeatures2(vk_physical_device_, &features2);
+    }
+
+    VkPhysicalDeviceVulkan13Features required_13_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    required_13_features.dynamicRendering = available_13_features.dynamicRendering;
+    required_13_features.synchronization2 = available_13_features.synchronization2;
+
+    // The bindless texture table needs descriptor indexing, core in 1.2.
+    // Without all of it every texture keeps its own descriptor set.
+    VkPhysicalDeviceVulkan12Features available_12_features = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES
+    };
+    VkPhysicalDeviceVulkan12Properties properties_12 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES};
+    if (properties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceFeatures2 features2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, &available_12_features};
+        vkGetPhysicalDeviceFeatures2(vk_physical_device_, &features2);
+        VkPhysicalDeviceProperties2 properties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, &properties_12};
+        vkGetPhysicalDeviceProperties2(vk_physical_device_, &properties2);
+    }
+
+    VkPhysicalDeviceVulkan12Features required_12_features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES};
+    if (available_features.shaderSampledImageArrayDynamicIndexing &&
+        available_12_features.descriptorIndexing && available_12_features.runtimeDescriptorArray &&
+        available_12_features.descriptorBindingPartiallyBound &&
+        available_12_features.descriptorBindingSampledImageUpdateAfterBind) {
+        required_features.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+        required_12_features.descriptorIndexing = VK_TRUE;
+        required_12_features.runtimeDescriptorArray = VK_TRUE;
+        required_12_features.descriptorBindingPartiallyBound = VK_TRUE;
+        required_12_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    }
+    if (properties.apiVersion >= VK_API_VERSION_1_3)
+        required_12_features.pNext = &required_13_features;
+
+    const std::vector<const char *> extensions = GetRequiredDeviceExtensions();
 
     VkDeviceCreateInfo deviceCreateInfo = {
         VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO, nullptr, 0, static_cast<uint32_t>(queueCreateInfos.size()),
-        queueCreateInfos.data(), 0, nullptr, static_cast<uint32_t>(deviceExtensions.size()),
-        deviceExtensions.data(),
+        queueCreateInfos.data(), 0, nullptr, static_cast<uint32_t>(extensions.size()),
+        extensions.data(),
         &required_features
     };
+    if (properties.apiVersion >= VK_API_VERSION_1_2)
+        deviceCreateInfo.pNext = &required_12_features;
 
     VkResult result = vkCreateDevice(vk_physical_device_, &deviceCreateInfo, nullptr, &vk_device_);
     if (result != VK_SUCCESS) {
@@ -327,8 +415,36 @@ void VulkanRenderer::CreateLogicalDeviceAndQueues() {
         std::exit(EXIT_FAILURE);
     }
 
+    dynamic_rendering_ = required_13_features.dynamicRendering == VK_TRUE;
+    synchronization2_ = required_13_features.synchronization2 == VK_TRUE;
+    spdlog::info("Dynamic rendering {}, synchronization2 {}", dynamic_rendering_ ? "on" : "off",
+                 synchronization2_ ? "on" : "off");
+
+    // Combined image samplers count against both the sampled image and the
+    // sampler limits, and every limit covers the whole pipeline layout, so
+    // what the fragment stage binds besides the table comes off first.
+    const auto remaining = [](const std::uint32_t limit, const std::uint32_t used) {
+        return limit > used ? limit - used : 0;
+    };
+    bindless_capacity_ = std::min({
+        kMaxBindlessTextures,
+        remaining(properties_12.maxDescriptorSetUpdateAfterBindSampledImages, kMainFragmentSamplers),
+        remaining(properties_12.maxDescriptorSetUpdateAfterBindSamplers, kMainFragmentSamplers),
+        remaining(properties_12.maxPerStageDescriptorUpdateAfterBindSampledImages, kMainFragmentSamplers),
+        remaining(properties_12.maxPerStageDescriptorUpdateAfterBindSamplers, kMainFragmentSamplers),
+        remaining(properties_12.maxPerStageUpdateAfterBindResources, kMainFragmentResources)
+    });
+    bindless_textures_ = required_12_features.descriptorIndexing == VK_TRUE && bindless_capacity_ > 0;
+    if (bindless_textures_)
+        spdlog::info("Bindless textures on, {} slots", bindless_capacity_);
+    else
+        spdlog::info("Bindless textures off");
+
     vkGetDeviceQueue(vk_device_, indices.graphicsFamily.value(), 0, &vk_graphics_queue_);
     vkGetDeviceQueue(vk_device_, indices.presentFamily.value(), 0, &vk_present_queue_);
+    if (indices.computeFamily)
+        vkGetDeviceQueue(vk_device_, indices.computeFamily.value(), 0, &vk_compute_queue_);
+    queue_families_ = indices;
 }
 
 
@@ -392,6 +508,11 @@ std::uint32_t VulkanRenderer::ChooseImageCount(const VkSurfaceCapabilitiesKHR &c
 }
 
 void VulkanRenderer::CreateSwapChain() {
+    if (headless_) {
+        CreateOffscreenTargets();
+        return;
+    }
+
     SwapchainSupportCapabilities capabilities = FindSwapChainSupport(vk_physical_device_);
 
     vk_surface_format_ = ChooseSwapchainSurfaceFormat(capabilities.formats_khr);
@@ -441,6 +562,62 @@ void VulkanRenderer::CreateSwapChain() {
     vkGetSwapchainImagesKHR(vk_device_, vk_swapchain_, &actual_image_count, vk_swapchain_images_.data());
 }
 
+void VulkanRenderer::CreateOffscreenTargets() {
+    vk_surface_format_ = {kHeadlessColorFormat, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR};
+
+    vk_swapchain_images_.resize(kHeadlessImageCount);
+    vk_offscreen_memory_.resize(kHeadlessImageCount);
+    for (std::uint32_t i = 0; i < kHeadlessImageCount; i++) {
+        TextureHandle target = CreateImage({vk_extent_.width, vk_extent_.height}, kHeadlessColorFormat,
+                                           VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+                                           VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        vk_swapchain_images_[i] = target.image;
+        vk_offscreen_memory_[i] = target.memory;
+    }
+    current_image_index_ = kHeadlessImageCount - 1;
+}
+
+bool VulkanRenderer::ReadbackFrame(const std::filesystem::path &path) {
+    if (!headless_) {
+        spdlog::error("Frame readback is only available in headless mode");
+        return false;
+    }
+
+    vkWaitForFences(vk_device_, 1, &vk_still_rendering_fence_, VK_TRUE, UINT64_MAX);
+
+    const VkDeviceSize buffer_size = static_cast<VkDeviceSize>(vk_extent_.width) * vk_extent_.height * 4;
+    BufferHandle staging_buffer = CreateBuffer(buffer_size, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    // The frame graph leaves the target in TRANSFER_SRC_OPTIMAL.
+    VkCommandBuffer command_buffer = BeginTransientCommandBuffer();
+    VkBufferImageCopy region = {};
+    region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+    region.imageExtent = {vk_extent_.width, vk_extent_.height, 1};
+    vkCmdCopyImageToBuffer(command_buffer, vk_swapchain_images_[current_image_index_],
+                           VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, staging_buffer.buffer, 1, &region);
+    EndTransientCommandBuffer(command_buffer);
+
+    void *data;
+    vkMapMemory(vk_device_, staging_buffer.memory, 0, buffer_size, 0, &data);
+    const auto *pixels = static_cast<const std::uint8_t *>(data);
+
+    std::ofstream file(path, std::ios::binary);
+    const bool opened = file.is_open();
+    if (opened) {
+        file << "P6\n" << vk_extent_.width << " " << vk_extent_.height << "\n255\n";
+        for (std::size_t i = 0; i < static_cast<std::size_t>(vk_extent_.width) * vk_extent_.height; i++)
+            file.write(reinterpret_cast<const char *>(pixels + i * 4), 3);
+    } else {
+        spdlog::error("Failed to open {} for frame readback", path.string());
+    }
+
+    vkUnmapMemory(vk_device_, staging_buffer.memory);
+    DestroyBuffer(staging_buffer);
+    return opened;
+}
+
 VkImageView VulkanRenderer::CreateImageView(VkImage image, const VkFormat format,
                                             VkImageAspectFlags aspect_flags) const {
     VkImageViewCreateInfo view_create_info = {};
@@ -500,22 +677,84 @@ void VulkanRenderer::CreateGraphicsPipeline() {
     main_pipeline_helper_ = {
         {"shaders/basic.vert.spv", "shaders/basic.frag.spv"}, {oVertex::GetBindingDescription()},
         oVertex::GetAttributeDescriptions(), VK_CULL_MODE_NONE, {true, true, VK_COMPARE_OP_LESS},
-        {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4)}},
+        {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(DrawTransform)}},
         {vk_uniform_set_layout_, vk_uniform_bp_set_layout_, vk_texture_set_layout_, vk_lights_set_layout_}
     };
+    if (bindless_textures_) {
+        // Set 2 becomes the texture table and the fragment stage gets the
+        // texture index right after the model transform.
+        main_pipeline_helper_.shaders[1] = "shaders/basic_bindless.frag.spv";
+        main_pipeline_helper_.push_constant_ranges.push_back(
+            {VK_SHADER_STAGE_FRAGMENT_BIT, kTextureIndexPushOffset, sizeof(std::uint32_t)});
+        main_pipeline_helper_.descriptor_set_layouts[2] = vk_bindless_set_layout_;
+    }
     main_pipeline_helper_.color_blend_attachment = new VkPipelineColorBlendAttachmentState{
         VK_TRUE, VK_BLEND_FACTOR_SRC_ALPHA, VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA, VK_BLEND_OP_ADD, VK_BLEND_FACTOR_ONE,
         VK_BLEND_FACTOR_ZERO, VK_BLEND_OP_ADD,
         VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
     };
+    main_pipeline_helper_.render_pass = post_processing_.render_pass;
+    main_pipeline_helper_.depth_format = FindDepthFormat();
+    CreatePipeline(main_pipeline_helper_);
+    CreateMainPipelineVariants();
+}
+
+void VulkanRenderer::CreateMainPipelineVariants() {
+    // Both variants reuse the main layout, so the pre-pass and the color pass
+    // bind the same sets and push the model transform the same way.
+    depth_prepass_pipeline_helper_ = main_pipeline_helper_;
+    depth_prepass_pipeline_helper_.shaders = {main_pipeline_helper_.shaders[0]};
+    depth_prepass_pipeline_helper_.pipeline = VK_NULL_HANDLE;
+    CreatePipeline(depth_prepass_pipeline_helper_);
+
+    PipelineHelper equal_pipeline_helper = main_pipeline_helper_;
+    equal_pipeline_helper.depth_helper = {true, false, VK_COMPARE_OP_EQUAL};
+    equal_pipeline_helper.pipeline = VK_NULL_HANDLE;
+    CreatePipeline(equal_pipeline_helper);
+    main_equal_pipeline_ = equal_pipeline_helper.pipeline;
+}
+
+void VulkanRenderer::SetSceneVertexInput(PipelineHelper &pipeline_helper) const {
+    if (vertex_format_ == VertexFormat::Compact) {
+        pipeline_helper.vertex_input_binding_description = {oCompactVertex::GetBindingDescription()};
+        pipeline_helper.vertex_input_attribute_description = oCompactVertex::GetAttributeDescriptions();
+    } else {
+        pipeline_helper.vertex_input_binding_description = {oVertex::GetBindingDescription()};
+        pipeline_helper.vertex_input_attribute_description = oVertex::GetAttributeDescriptions();
+    }
+}
+
+void VulkanRenderer::SetVertexFormat(const VertexFormat format) {
+    if (format == vertex_format_) return;
+    vertex_format_ = format;
+
+    // The layouts stay: only the vertex input and the vertex shader change.
+    vkDeviceWaitIdle(vk_device_);
+    for (const VkPipeline pipeline: {main_pipeline_helper_.pipeline, depth_prepass_pipeline_helper_.pipeline,
+                                     main_equal_pipeline_, shadow_pipeline_helper_.pipeline})
+        if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(vk_device_, pipeline, nullptr);
+
+    main_pipeline_helper_.shaders[0] =
+        format == VertexFormat::Compact ? "shaders/basic_compact.vert.spv" : "shaders/basic.vert.spv";
+    SetSceneVertexInput(main_pipeline_helper_);
+    main_pipeline_helper_.pipeline = VK_NULL_HANDLE;
     CreatePipeline(main_pipeline_helper_);
+    CreateMainPipelineVariants();
+
+    // shadow.vert reads the unorm position as a vec3; the model matrix decodes it.
+    SetSceneVertexInput(shadow_pipeline_helper_);
+    shadow_pipeline_helper_.pipeline = VK_NULL_HANDLE;
+    CreatePipeline(shadow_pipeline_helper_);
 }
 
 void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
+    // A pipeline with only a vertex shader is depth-only: it writes no color.
+    const bool depth_only = pipeline_helper.shaders.size() == 1;
     VkShaderModule vertex_shader = CreateShaderModule(ReadFile(pipeline_helper.shaders[0]));
-    VkShaderModule fragment_shader = CreateShaderModule(ReadFile(pipeline_helper.shaders[1]));
+    VkShaderModule fragment_shader =
+            depth_only ? VK_NULL_HANDLE : CreateShaderModule(ReadFile(pipeline_helper.shaders[1]));
 
-    if (vertex_shader == VK_NULL_HANDLE || fragment_shader == VK_NULL_HANDLE) {
+    if (vertex_shader == VK_NULL_HANDLE || (!depth_only && fragment_shader == VK_NULL_HANDLE)) {
         spdlog::error("Failed finding shaders!");
         std::exit(EXIT_FAILURE);
     }
@@ -531,6 +770,7 @@ void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
     };
 
     std::array stage_infos = {vertex_info, fragment_info};
+    const std::uint32_t stage_count = depth_only ? 1 : static_cast<std::uint32_t>(stage_infos.size());
 
     std::array dynamic_states = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
 
@@ -566,6 +806,11 @@ void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
         VK_POLYGON_MODE_FILL, pipeline_helper.cull_mode, VK_FRONT_FACE_CLOCKWISE, VK_FALSE
     };
     rasterization_state_info.lineWidth = 1.0f;
+    if (pipeline_helper.depth_bias != glm::vec2(0.0f)) {
+        rasterization_state_info.depthBiasEnable = VK_TRUE;
+        rasterization_state_info.depthBiasConstantFactor = pipeline_helper.depth_bias.x;
+        rasterization_state_info.depthBiasSlopeFactor = pipeline_helper.depth_bias.y;
+    }
 
     VkPipelineMultisampleStateCreateInfo multisample_info = {
         VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
@@ -582,14 +827,18 @@ void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
     depthStencil_create_info.maxDepthBounds = 1.0f;
 
     VkPipelineColorBlendAttachmentState color_blend_attachment{};
-    color_blend_attachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
-                                            VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    color_blend_attachment.colorWriteMask = depth_only
+                                                ? 0
+                                                : VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
+                                                  VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     color_blend_attachment.blendEnable = VK_FALSE;
 
     VkPipelineColorBlendStateCreateInfo color_blend_state = {
         VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        nullptr, 0, VK_FALSE, VK_LOGIC_OP_NO_OP, 1,
-        pipeline_helper.color_blend_attachment ? pipeline_helper.color_blend_attachment : &color_blend_attachment
+        nullptr, 0, VK_FALSE, VK_LOGIC_OP_NO_OP, pipeline_helper.color_attachment_count,
+        pipeline_helper.color_blend_attachment && !depth_only
+            ? pipeline_helper.color_blend_attachment
+            : &color_blend_attachment
     };
 
     VkPipelineLayoutCreateInfo pipeline_layout_info = {
@@ -599,21 +848,38 @@ void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
         static_cast<uint32_t>(pipeline_helper.push_constant_ranges.size()), pipeline_helper.push_constant_ranges.data()
     };
 
-    if (VkResult result = vkCreatePipelineLayout(vk_device_, &pipeline_layout_info, nullptr,
-                                                 &pipeline_helper.pipeline_layout);
-        result != VK_SUCCESS) {
-        spdlog::error("failed to create pipeline layout!");
-        std::exit(EXIT_FAILURE);
+    if (pipeline_helper.pipeline_layout == VK_NULL_HANDLE) {
+        if (VkResult result = vkCreatePipelineLayout(vk_device_, &pipeline_layout_info, nullptr,
+                                                     &pipeline_helper.pipeline_layout);
+            result != VK_SUCCESS) {
+            spdlog::error("failed to create pipeline layout!");
+            std::exit(EXIT_FAILURE);
+        }
     }
 
     VkGraphicsPipelineCreateInfo pipeline_info = {
-        VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, nullptr, 0, stage_infos.size(), stage_infos.data(),
+        VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO, nullptr, 0, stage_count, stage_infos.data(),
         &vertex_input_info, &input_assembly_info, nullptr, &viewport_state_info, &rasterization_state_info,
         &multisample_info, &depthStencil_create_info, &color_blend_state, &dynamic_state_info,
-        pipeline_helper.pipeline_layout, vk_render_pass_, 0
+        pipeline_helper.pipeline_layout,
+        pipeline_helper.render_pass != VK_NULL_HANDLE ? pipeline_helper.render_pass : vk_render_pass_, 0
     };
 
-    VkResult pipeline_result = vkCreateGraphicsPipelines(vk_device_, VK_NULL_HANDLE, 1, &pipeline_info, nullptr,
+    // Without render passes the pipeline names its attachment formats instead.
+    // Every color target shares the surface format.
+    VkPipelineRenderingCreateInfo rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    rendering_info.colorAttachmentCount = pipeline_helper.color_attachment_count;
+    rendering_info.pColorAttachmentFormats = &vk_surface_format_.format;
+    rendering_info.depthAttachmentFormat = pipeline_helper.depth_format;
+    if (HasStencilComponent(pipeline_helper.depth_format))
+        rendering_info.stencilAttachmentFormat = pipeline_helper.depth_format;
+    if (dynamic_rendering_) {
+        pipeline_info.pNext = &rendering_info;
+        pipeline_info.renderPass = VK_NULL_HANDLE;
+    }
+
+    VkResult pipeline_result = vkCreateGraphicsPipelines(vk_device_, vk_pipeline_cache_, 1, &pipeline_info, nullptr,
                                                          &pipeline_helper.pipeline);
     if (pipeline_result != VK_SUCCESS) {
         spdlog::error("failed to create pipeline!");
@@ -624,6 +890,89 @@ void VulkanRenderer::CreatePipeline(PipelineHelper &pipeline_helper) {
     vkDestroyShaderModule(vk_device_, fragment_shader, nullptr);
 }
 
+PipelineCacheFileHeader VulkanRenderer::GetPipelineCacheHeader() const {
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(vk_physical_device_, &properties);
+
+    PipelineCacheFileHeader header;
+    header.vendor_id = properties.vendorID;
+    header.device_id = properties.deviceID;
+    header.driver_version = properties.driverVersion;
+    std::memcpy(header.pipeline_cache_uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+void VulkanRenderer::CreatePipelineCache() {
+    const PipelineCacheFileHeader expected = GetPipelineCacheHeader();
+    std::vector<std::uint8_t> file = ReadFile(pipeline_cache_path_);
+
+    const void *initial_data = nullptr;
+    std::size_t initial_size = 0;
+    if (file.size() >= sizeof(PipelineCacheFileHeader)) {
+        PipelineCacheFileHeader header;
+        std::memcpy(&header, file.data(), sizeof(header));
+
+        const bool valid = header.magic == expected.magic && header.version == expected.version &&
+                           header.vendor_id == expected.vendor_id && header.device_id == expected.device_id &&
+                           header.driver_version == expected.driver_version &&
+                           std::memcmp(header.pipeline_cache_uuid, expected.pipeline_cache_uuid, VK_UUID_SIZE) == 0
+                           && header.data_size == file.size() - sizeof(header);
+        if (valid) {
+            initial_data = file.data() + sizeof(header);
+            initial_size = header.data_size;
+        } else {
+            spdlog::info("Pipeline cache {} is stale or from another device, rebuilding",
+                         pipeline_cache_path_.string());
+        }
+    }
+
+    VkPipelineCacheCreateInfo cache_info = {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.initialDataSize = initial_size;
+    cache_info.pInitialData = initial_data;
+
+    if (vkCreatePipelineCache(vk_device_, &cache_info, nullptr, &vk_pipeline_cache_) != VK_SUCCESS) {
+        // Not fatal: pipelines are simply compiled without a cache.
+        spdlog::warn("Failed to create pipeline cache");
+        vk_pipeline_cache_ = VK_NULL_HANDLE;
+        return;
+    }
+
+    if (initial_size > 0) spdlog::info("Loaded {} byte pipeline cache", initial_size);
+}
+
+void VulkanRenderer::SavePipelineCache() const {
+    if (vk_pipeline_cache_ == VK_NULL_HANDLE) return;
+
+    std::size_t data_size = 0;
+    if (vkGetPipelineCacheData(vk_device_, vk_pipeline_cache_, &data_size, nullptr) != VK_SUCCESS || data_size == 0)
+        return;
+
+    std::vector<std::uint8_t> data(data_size);
+    if (vkGetPipelineCacheData(vk_device_, vk_pipeline_cache_, &data_size, data.data()) != VK_SUCCESS) return;
+
+    PipelineCacheFileHeader header = GetPipelineCacheHeader();
+    header.data_size = data_size;
+
+    // Write next to the real file and swap it in, so a crash mid-write never
+    // leaves a truncated cache behind.
+    std::filesystem::path temporary_path = pipeline_cache_path_;
+    temporary_path += ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            spdlog::warn("Failed to write pipeline cache {}", temporary_path.string());
+            return;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data_size));
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path, pipeline_cache_path_, error);
+    if (error) spdlog::warn("Failed to replace pipeline cache: {}", error.message());
+}
+
 VkViewport VulkanRenderer::GetViewport() const {
     const VkViewport viewport = {
         0, 0, static_cast<float>(vk_extent_.width),
@@ -638,6 +987,8 @@ VkRect2D VulkanRenderer::GetScissor() const {
 }
 
 void VulkanRenderer::CreateRenderPass() {
+    if (dynamic_rendering_) return;
+
     // Color attachment
     VkAttachmentDescription color_attachment{};
     color_attachment.format = vk_surface_format_.format;
@@ -646,57 +997,29 @@ void VulkanRenderer::CreateRenderPass() {
     color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    // Depth attachment
-    VkAttachmentDescription depth_attachment{};
-    depth_attachment.format = FindDepthFormat();
-    depth_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    // The frame graph transitions the swapchain image around the pass.
+    color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // Attachment references
     VkAttachmentReference color_attachment_ref{};
     color_attachment_ref.attachment = 0;
     color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
-    VkAttachmentReference depth_attachment_ref{};
-    depth_attachment_ref.attachment = 1;
-    depth_attachment_ref.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    // Create subpass
+    // Create subpass. Only the last post pass renders here, so it has no depth.
     VkSubpassDescription subpass{};
     subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
     subpass.colorAttachmentCount = 1;
     subpass.pColorAttachments = &color_attachment_ref;
-    subpass.pDepthStencilAttachment = &depth_attachment_ref;
-
-    // Subpass dependencies
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
     // Create render pass
-    std::array<VkAttachmentDescription, 2> attachments = {color_attachment, depth_attachment};
+    std::array<VkAttachmentDescription, 1> attachments = {color_attachment};
     VkRenderPassCreateInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
     render_pass_info.attachmentCount = static_cast<uint32_t>(attachments.size());
     render_pass_info.pAttachments = attachments.data();
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
 
     if (vkCreateRenderPass(vk_device_, &render_pass_info, nullptr, &vk_render_pass_) != VK_SUCCESS) {
         throw std::runtime_error("failed to create render pass!");
@@ -704,10 +1027,12 @@ void VulkanRenderer::CreateRenderPass() {
 }
 
 void VulkanRenderer::CreateFramebuffers() {
+    if (dynamic_rendering_) return;
+
     vk_swapchain_framebuffers_.resize(vk_swapchain_image_views_.size());
 
     for (std::uint32_t i = 0; i < vk_swapchain_image_views_.size(); i++) {
-        std::array attachments = std::array{vk_swapchain_image_views_[i], depth_texture_.image_view};
+        std::array attachments = std::array{vk_swapchain_image_views_[i]};
         VkFramebufferCreateInfo framebuffer_info = {};
         framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
         framebuffer_info.renderPass = vk_render_pass_;
@@ -752,14 +1077,40 @@ void VulkanRenderer::CreateCommandBuffer() {
     }
 }
 
+static ImageBarrier MakeImageBarrier(VkImage image, const VkImageLayout old_layout, const VkImageLayout new_layout,
+                                     const VkPipelineStageFlags2 src_stages, const VkAccessFlags2 src_access,
+                                     const VkPipelineStageFlags2 dst_stages, const VkAccessFlags2 dst_access) {
+    ImageBarrier barrier;
+    barrier.image = image;
+    barrier.old_layout = old_layout;
+    barrier.new_layout = new_layout;
+    barrier.src_stages = src_stages;
+    barrier.src_access = src_access;
+    barrier.dst_stages = dst_stages;
+    barrier.dst_access = dst_access;
+    return barrier;
+}
+
 void VulkanRenderer::BeginCommands() {
     vkResetCommandBuffer(vk_command_buffer_, 0);
+    render_stats_ = {};
 
     VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 
     VkResult result = vkBeginCommandBuffer(vk_command_buffer_, &begin_info);
     if (result != VK_SUCCESS) throw std::runtime_error("failed to begin command buffer commands");
 
+    if (gpu_timestamps_.query_pool != VK_NULL_HANDLE) {
+        const std::uint32_t slot = gpu_timestamps_.frame % GpuTimestamps::kFrames;
+        vkCmdResetQueryPool(vk_command_buffer_, gpu_timestamps_.query_pool, slot * GpuTimestamps::kQueriesPerFrame,
+                            GpuTimestamps::kQueriesPerFrame);
+    }
+
+    draw_list_.Clear();
+}
+
+void VulkanRenderer::RecordScenePass() {
+    PROFILE_FUNCTION();
     // First render pass (scene)
     std::array<VkClearValue, 2> clear_values = {}; // Zero initialize all values
 
@@ -772,67 +1123,330 @@ void VulkanRenderer::BeginCommands() {
     depth_clear.stencil = 0;
     clear_values[1].depthStencil = depth_clear;
 
-    VkRenderPassBeginInfo render_pass_info{};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_pass_info.renderPass = post_processing_.render_pass; // Use the main render pass for the first pass
-    render_pass_info.framebuffer = post_processing_.framebuffer;
-    render_pass_info.renderArea = {{0, 0}, vk_extent_};
-    render_pass_info.clearValueCount = clear_values.size();
-    render_pass_info.pClearValues = clear_values.data();
+    WriteTimestamp(GpuScope::ScenePass, false);
+    if (dynamic_rendering_) {
+        // The frame graph has the attachments in their layouts by now.
+        const VkFormat depth_format = FindDepthFormat();
+
+        VkRenderingAttachmentInfo color_attachment{};
+        color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        color_attachment.imageView = post_processing_.color_view;
+        color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.clearValue = clear_values[0];
+
+        VkRenderingAttachmentInfo depth_attachment{};
+        depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        depth_attachment.imageView = post_processing_.depth_view;
+        depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.clearValue = clear_values[1];
+
+        VkRenderingInfo rendering_info{};
+        rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        rendering_info.renderArea = {{0, 0}, vk_extent_};
+        rendering_info.layerCount = 1;
+        rendering_info.colorAttachmentCount = 1;
+        rendering_info.pColorAttachments = &color_attachment;
+        rendering_info.pDepthAttachment = &depth_attachment;
+        if (HasStencilComponent(depth_format)) rendering_info.pStencilAttachment = &depth_attachment;
+        // The draws are recorded into secondaries, possibly on other threads.
+        rendering_info.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+        vkCmdBeginRendering(vk_command_buffer_, &rendering_info);
+    } else {
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = post_processing_.render_pass; // Use the main render pass for the first pass
+        render_pass_info.framebuffer = post_processing_.framebuffer;
+        render_pass_info.renderArea = {{0, 0}, vk_extent_};
+        render_pass_info.clearValueCount = clear_values.size();
+        render_pass_info.pClearValues = clear_values.data();
+        vkCmdBeginRenderPass(vk_command_buffer_, &render_pass_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    }
+
+    // Each slot records a contiguous run of the sorted packets into its own
+    // secondary. Slot 0 runs on this thread and also records the depth
+    // pre-pass, so the secondaries execute in sorted order after it.
+    draw_list_.Sort();
+    const std::span<const DrawPacket> packets = draw_list_.GetPackets();
+    const std::size_t slot_count = std::clamp<std::size_t>(packets.size() / kMinDrawsPerRecordingSlot, 1,
+                                                           recording_slots_.size());
+    const std::size_t packets_per_slot = (packets.size() + slot_count - 1) / slot_count;
+    const auto slot_draws = [packets, packets_per_slot](const std::size_t slot) {
+        const std::size_t first = std::min(slot * packets_per_slot, packets.size());
+        return packets.subspan(first, std::min(packets_per_slot, packets.size() - first));
+    };
 
-    vkCmdBeginRenderPass(vk_command_buffer_, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    std::vector<std::future<void>> recordings;
+    recordings.reserve(slot_count - 1);
+    for (std::size_t i = 1; i < slot_count; ++i) {
+        recordings.push_back(recording_pool_->Submit([this, i, slot_draws] {
+            PROFILE_SCOPE("RecordSceneSlot");
+            RecordingSlot &slot = recording_slots_[i];
+            vkResetCommandPool(vk_device_, slot.command_pool, 0);
+            slot.stats = {};
+            BeginSceneSecondary(slot.command_buffer);
+            RecordSceneDraws(slot.command_buffer, slot_draws(i), slot.stats);
+            if (vkEndCommandBuffer(slot.command_buffer) != VK_SUCCESS)
+                throw std::runtime_error("failed to end secondary command buffer");
+        }));
+    }
 
-    RenderSkybox();
+    RecordingSlot &main_slot = recording_slots_[0];
+    vkResetCommandPool(vk_device_, main_slot.command_pool, 0);
+    main_slot.stats = {};
+    BeginSceneSecondary(main_slot.command_buffer);
+    // Timestamps are written with the pre-pass off too, or the frame's
+    // queries would never all become available.
+    WriteTimestamp(GpuScope::DepthPrepass, false, main_slot.command_buffer);
+    if (depth_prepass_) RecordDepthPrepass(main_slot.command_buffer, packets, main_slot.stats);
+    WriteTimestamp(GpuScope::DepthPrepass, true, main_slot.command_buffer);
+    WriteTimestamp(GpuScope::Opaque, false, main_slot.command_buffer);
+    RecordSceneDraws(main_slot.command_buffer, slot_draws(0), main_slot.stats);
+    if (vkEndCommandBuffer(main_slot.command_buffer) != VK_SUCCESS)
+        throw std::runtime_error("failed to end secondary command buffer");
+
+    // The skybox sits at the far plane and goes last, shading only what no
+    // opaque covered.
+    BeginSceneSecondary(skybox_command_buffer_);
+    WriteTimestamp(GpuScope::Opaque, true, skybox_command_buffer_);
+    WriteTimestamp(GpuScope::Skybox, false, skybox_command_buffer_);
+    RenderSkybox(skybox_command_buffer_);
+    WriteTimestamp(GpuScope::Skybox, true, skybox_command_buffer_);
+    if (vkEndCommandBuffer(skybox_command_buffer_) != VK_SUCCESS)
+        throw std::runtime_error("failed to end secondary command buffer");
+
+    {
+        PROFILE_SCOPE("WaitForRecording");
+        for (std::future<void> &recording: recordings)
+            recording.get();
+    }
 
-    vkCmdBindPipeline(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline);
-    VkViewport viewport = GetViewport();
-    VkRect2D scissor = GetScissor();
+    std::vector<VkCommandBuffer> secondaries;
+    secondaries.reserve(slot_count + 1);
+    for (std::size_t i = 0; i < slot_count; ++i) {
+        secondaries.push_back(recording_slots_[i].command_buffer);
+        render_stats_.draw_calls += recording_slots_[i].stats.draw_calls;
+        render_stats_.triangles += recording_slots_[i].stats.triangles;
+        render_stats_.binds += recording_slots_[i].stats.binds;
+        render_stats_.prepass_draw_calls += recording_slots_[i].stats.prepass_draw_calls;
+    }
+    secondaries.push_back(skybox_command_buffer_);
+    vkCmdExecuteCommands(vk_command_buffer_, static_cast<std::uint32_t>(secondaries.size()), secondaries.data());
 
-    vkCmdSetViewport(vk_command_buffer_, 0, 1, &viewport);
-    vkCmdSetScissor(vk_command_buffer_, 0, 1, &scissor);
+    if (dynamic_rendering_) vkCmdEndRendering(vk_command_buffer_);
+    else vkCmdEndRenderPass(vk_command_buffer_);
+    WriteTimestamp(GpuScope::ScenePass, true);
 }
 
-void VulkanRenderer::EndCommands() const {
-    vkCmdEndRenderPass(vk_command_buffer_);
+void VulkanRenderer::BeginSceneSecondary(VkCommandBuffer command_buffer) const {
+    const VkFormat depth_format = FindDepthFormat();
+    VkCommandBufferInheritanceRenderingInfo rendering_info{};
+    rendering_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+    rendering_info.colorAttachmentCount = 1;
+    rendering_info.pColorAttachmentFormats = &vk_surface_format_.format;
+    rendering_info.depthAttachmentFormat = depth_format;
+    if (HasStencilComponent(depth_format)) rendering_info.stencilAttachmentFormat = depth_format;
+    rendering_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkCommandBufferInheritanceInfo inheritance_info{};
+    inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+    if (dynamic_rendering_) {
+        inheritance_info.pNext = &rendering_info;
+    } else {
+        inheritance_info.renderPass = post_processing_.render_pass;
+        inheritance_info.subpass = 0;
+        inheritance_info.framebuffer = post_processing_.framebuffer;
+    }
 
-    // Second render pass (post-processing)
-    std::array<VkClearValue, 2> clear_values = {}; // Zero initialize all values
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+    begin_info.pInheritanceInfo = &inheritance_info;
+    if (vkBeginCommandBuffer(command_buffer, &begin_info) != VK_SUCCESS)
+        throw std::runtime_error("failed to begin secondary command buffer");
 
-    // Initialize color clear value
-    clear_values[0].color = {0.0f, 0.0f, 0.0f, 1.0f};
+    // Dynamic state is not inherited from the primary. Set once here, it
+    // holds for the skybox and every packet, as all pipelines make it dynamic.
+    VkViewport viewport = GetViewport();
+    VkRect2D scissor = GetScissor();
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
 
-    // Initialize depth clear value
-    VkClearDepthStencilValue depth_clear = {};
-    depth_clear.depth = 1.0f;
-    depth_clear.stencil = 0;
-    clear_values[1].depthStencil = depth_clear;
+void VulkanRenderer::EndCommands() {
+    WriteTimestamp(GpuScope::Shadows, false);
+    frame_graph_.Execute(vk_command_buffer_);
+    VkResult result = vkEndCommandBuffer(vk_command_buffer_);
+    if (result != VK_SUCCESS) throw std::runtime_error("failed to end command buffer commands");
+    if (!UsesAsyncCompute()) return;
 
-    VkRenderPassBeginInfo render_pass_info{};
-    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    render_pass_info.renderPass = vk_render_pass_;
-    render_pass_info.framebuffer = vk_swapchain_framebuffers_[current_image_index_];
-    render_pass_info.renderArea = {{0, 0}, vk_extent_};
-    render_pass_info.clearValueCount = clear_values.size();
-    render_pass_info.pClearValues = clear_values.data();
+    // The graphs release and acquire the images that cross between queues.
+    VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-    vkCmdBeginRenderPass(vk_command_buffer_, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    vkBeginCommandBuffer(vk_compute_command_buffer_, &begin_info);
+    post_processing_.compute_graph.Execute(vk_compute_command_buffer_);
+    vkEndCommandBuffer(vk_compute_command_buffer_);
 
-    vkCmdBindPipeline(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, post_processing_.pipeline.pipeline);
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            post_processing_.pipeline.pipeline_layout, 0, 1,
-                            &post_processing_.descriptor_set, 0, nullptr);
+    vkBeginCommandBuffer(vk_present_command_buffer_, &begin_info);
+    present_graph_.Execute(vk_present_command_buffer_);
+    vkEndCommandBuffer(vk_present_command_buffer_);
+}
 
-    VkViewport viewport = GetViewport();
-    VkRect2D scissor = GetScissor();
-    vkCmdSetViewport(vk_command_buffer_, 0, 1, &viewport);
-    vkCmdSetScissor(vk_command_buffer_, 0, 1, &scissor);
+void VulkanRenderer::BuildFrameGraph() {
+    frame_graph_.Destroy();
+    present_graph_.Destroy();
+    RenderGraph &graph = frame_graph_;
+    const bool async = UsesAsyncCompute();
+    RenderGraph &present_graph = async ? present_graph_ : frame_graph_;
+
+    const VkFormat depth_format = FindDepthFormat();
+    RenderGraphImageDesc depth_desc = {depth_format, vk_extent_, VK_IMAGE_ASPECT_DEPTH_BIT};
+    if (HasStencilComponent(depth_format)) depth_desc.aspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+
+    // Neither scene attachment keeps its contents. The color was last sampled
+    // by the previous frame's post chain; the depth was last written by it.
+    const RenderGraphResource scene_color = graph.ImportImage(
+        "SceneColor", post_processing_.color_image, post_processing_.color_view,
+        {vk_surface_format_.format, vk_extent_},
+        {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT});
+    const RenderGraphResource scene_depth = graph.ImportImage(
+        "SceneDepth", post_processing_.depth_image, post_processing_.depth_view, depth_desc,
+        {
+            VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+            VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+        });
+
+    const std::span<const ShadowView> shadow_views = shadow_cache_.GetViews();
+    const RenderGraphResource cascade_shadows = AddShadowPass(graph, "CascadeShadows", cascade_shadow_map_,
+                                                              shadow_views.first(kShadowCascades));
+    const RenderGraphResource point_shadows = AddShadowPass(graph, "PointShadows", point_shadow_map_,
+                                                            shadow_views.subspan(kShadowCascades));
+
+    graph.AddPass("Scene", RenderGraphPassType::Graphics)
+        .Read(cascade_shadows, RenderGraphAccess::Sampled)
+        .Read(point_shadows, RenderGraphAccess::Sampled)
+        .Write(scene_color, RenderGraphAccess::ColorAttachment)
+        .Write(scene_depth, RenderGraphAccess::DepthAttachment)
+        .Execute([this](VkCommandBuffer, const RenderGraph &) {
+            // Shadow time runs up to the scene pass, barriers included.
+            WriteTimestamp(GpuScope::Shadows, true);
+            RecordScenePass();
+            // Post-processing time includes the barriers in front of it.
+            WriteTimestamp(GpuScope::PostPass, false);
+        });
+
+    // What the present pass samples, in the graph it runs in.
+    RenderGraphResource source = scene_color;
+    PostTarget source_target;
+    source_target.descriptor_set = post_processing_.descriptor_set;
+    source_target.extent = vk_extent_;
+    std::array<RenderGraphResource, 3> bloom{};
+    const PostPass *present_pass = &post_processing_.present_pass;
+
+    if (post_processing_.use_compute) {
+        // The compute graph plans the barriers inside the chain. Its result is
+        // always a storage image one of its dispatches wrote.
+        source_target = post_processing_.compute_targets[post_processing_.compute_result];
+        const RenderGraphImageDesc result_desc = {kComputePostFormat, source_target.extent};
+        if (async) {
+            const std::uint32_t graphics_family = queue_families_.graphicsFamily.value();
+            const std::uint32_t compute_family = queue_families_.computeFamily.value();
+            graph.ExportImage(scene_color, {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}, graphics_family,
+                              compute_family);
+            source = present_graph.ImportImage("PostResult", source_target.image, source_target.view, result_desc,
+                                               {VK_IMAGE_LAYOUT_GENERAL}, compute_family, graphics_family);
+        } else {
+            graph.AddPass("ComputePost", RenderGraphPassType::Compute)
+                .Read(scene_color, RenderGraphAccess::Sampled)
+                .SideEffect()
+                .Execute([this](VkCommandBuffer command_buffer, const RenderGraph &) {
+                    post_processing_.compute_graph.Execute(command_buffer);
+                });
+            // Exported by the compute graph ready for the fragment stage.
+            source = graph.ImportImage("PostResult", source_target.image, source_target.view, result_desc,
+                                       {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+        }
+    } else {
+        // Chain targets were last sampled by a pass of the previous frame.
+        const auto import_target = [&graph, this](const std::string &name, const PostTarget &target) {
+            return graph.ImportImage(name, target.image, target.view, {vk_surface_format_.format, target.extent},
+                                     {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT});
+        };
+        const std::array ping_pong = {
+            import_target("PostChain0", post_processing_.ping_pong[0]),
+            import_target("PostChain1", post_processing_.ping_pong[1])
+        };
+        for (std::size_t i = 0; i < bloom.size(); ++i)
+            bloom[i] = import_target("Bloom" + std::to_string(i), post_processing_.bloom[i]);
+
+        // Every pass but the last renders into a ping-pong or bloom target.
+        std::size_t ping_pong_index = 0;
+        present_pass = &post_processing_.passes.back();
+        for (std::size_t i = 0; i + 1 < post_processing_.passes.size(); ++i) {
+            const PostPass &pass = post_processing_.passes[i];
+            const bool to_bloom = pass.bloom_output >= 0;
+            const RenderGraphResource input = pass.bloom_input >= 0 ? bloom[pass.bloom_input] : source;
+            const PostTarget input_target = pass.bloom_input >= 0 ? post_processing_.bloom[pass.bloom_input]
+                                                                  : source_target;
+            const std::size_t target_index = to_bloom ? pass.bloom_output : ping_pong_index++ % 2;
+            const RenderGraphResource output = to_bloom ? bloom[target_index] : ping_pong[target_index];
+            const PostTarget &target = to_bloom ? post_processing_.bloom[target_index]
+                                                : post_processing_.ping_pong[target_index];
+
+            RenderGraph::PassBuilder builder = graph.AddPass(pass.shader, RenderGraphPassType::Graphics);
+            builder.Read(input, RenderGraphAccess::Sampled).Write(output, RenderGraphAccess::ColorAttachment);
+            if (pass.samples_bloom) builder.Read(bloom.back(), RenderGraphAccess::Sampled);
+            builder.Execute([this, &pass, input_target, &target](VkCommandBuffer command_buffer, const RenderGraph &) {
+                RecordPostPass(command_buffer, pass, input_target.descriptor_set, input_target.extent, target, false);
+            });
+
+            if (!to_bloom) {
+                source = output;
+                source_target = target;
+            }
+        }
+    }
 
-    vkCmdDraw(vk_command_buffer_, 3, 1, 0, 0); // Draw fullscreen triangle
+    // The acquire semaphore already ordered the presentation engine's read.
+    // Headless, ReadbackFrame copies the image out after the frame fence.
+    const PostTarget swapchain = GetSwapchainTarget();
+    const RenderGraphResource swapchain_image = present_graph.ImportImage(
+        "Swapchain", swapchain.image, swapchain.view, {vk_surface_format_.format, vk_extent_},
+        {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT});
+    RenderGraphImageState presented = {VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+    if (headless_)
+        presented = {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT};
+    present_graph.ExportImage(swapchain_image, presented);
+
+    RenderGraph::PassBuilder present = present_graph.AddPass("Present", RenderGraphPassType::Graphics);
+    present.Read(source, RenderGraphAccess::Sampled).Write(swapchain_image, RenderGraphAccess::ColorAttachment);
+    if (present_pass->samples_bloom) present.Read(bloom.back(), RenderGraphAccess::Sampled);
+    present.Execute([this, present_pass, source_target, swapchain](VkCommandBuffer command_buffer,
+                                                                    const RenderGraph &) {
+        RecordPostPass(command_buffer, *present_pass, source_target.descriptor_set, source_target.extent, swapchain,
+                       true);
+        WriteTimestamp(GpuScope::PostPass, true, command_buffer);
+    });
 
-    vkCmdEndRenderPass(vk_command_buffer_);
+    graph.Compile(vk_device_, GetGraphAllocator(), synchronization2_);
+    if (async) present_graph.Compile(vk_device_, GetGraphAllocator(), synchronization2_);
+}
 
-    VkResult result = vkEndCommandBuffer(vk_command_buffer_);
-    if (result != VK_SUCCESS) throw std::runtime_error("failed to end command buffer commands");
+RenderGraphAllocator VulkanRenderer::GetGraphAllocator() {
+    return {
+        [this](std::uint32_t memory_type_bits) {
+            return FindMemoryType(memory_type_bits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        },
+        [this](VkDeviceSize size, std::uint32_t memory_type) {
+            VkMemoryAllocateInfo allocate_info = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, size, memory_type};
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            return AllocateDeviceMemory(&allocate_info, &memory) == VK_SUCCESS ? memory : VK_NULL_HANDLE;
+        },
+        [this](VkDeviceMemory memory) { FreeDeviceMemory(memory); }
+    };
 }
 
 void VulkanRenderer::CreateSignals() {
@@ -856,16 +1470,122 @@ void VulkanRenderer::CreateSignals() {
     }
 }
 
+void VulkanRenderer::CreateAsyncComputeResources() {
+    if (vk_compute_queue_ == VK_NULL_HANDLE) return;
+
+    VkCommandPoolCreateInfo pool_info = {
+        VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+        VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT, queue_families_.computeFamily.value()
+    };
+    if (vkCreateCommandPool(vk_device_, &pool_info, nullptr, &vk_compute_command_pool_) != VK_SUCCESS) {
+        spdlog::error("failed to create compute command pool!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    VkCommandBufferAllocateInfo alloc_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        nullptr, vk_compute_command_pool_, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1
+    };
+    if (vkAllocateCommandBuffers(vk_device_, &alloc_info, &vk_compute_command_buffer_) != VK_SUCCESS) {
+        spdlog::error("failed to allocate compute command buffer!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    alloc_info.commandPool = vk_command_pool_;
+    if (vkAllocateCommandBuffers(vk_device_, &alloc_info, &vk_present_command_buffer_) != VK_SUCCESS) {
+        spdlog::error("failed to allocate present command buffer!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    VkSemaphoreCreateInfo semaphore_info = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    if (vkCreateSemaphore(vk_device_, &semaphore_info, nullptr, &vk_scene_finished_signal_) != VK_SUCCESS ||
+        vkCreateSemaphore(vk_device_, &semaphore_info, nullptr, &vk_post_finished_signal_) != VK_SUCCESS) {
+        spdlog::error("failed to create async compute signals!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    spdlog::info("Async compute queue available (family {})", queue_families_.computeFamily.value());
+}
+
+void VulkanRenderer::DestroyAsyncComputeResources() {
+    if (vk_scene_finished_signal_ != VK_NULL_HANDLE)
+        vkDestroySemaphore(vk_device_, vk_scene_finished_signal_, nullptr);
+    if (vk_post_finished_signal_ != VK_NULL_HANDLE)
+        vkDestroySemaphore(vk_device_, vk_post_finished_signal_, nullptr);
+    if (vk_compute_command_pool_ != VK_NULL_HANDLE)
+        vkDestroyCommandPool(vk_device_, vk_compute_command_pool_, nullptr);
+}
+
+void VulkanRenderer::CreateRecordingResources() {
+    // Leave a core for whatever else the engine runs alongside the frame.
+    const std::size_t threads = std::clamp<std::size_t>(std::thread::hardware_concurrency(), 2,
+                                                        kMaxRecordingThreads + 1) - 1;
+    recording_slots_.resize(threads);
+    recording_pool_ = std::make_unique<ThreadPool>(threads - 1, "Render worker");
+
+    // Transient pools, reset as a whole every frame; one per slot so the
+    // threads never share a pool.
+    for (RecordingSlot &slot: recording_slots_) {
+        VkCommandPoolCreateInfo pool_info = {
+            VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO, nullptr,
+            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT, queue_families_.graphicsFamily.value()
+        };
+        if (vkCreateCommandPool(vk_device_, &pool_info, nullptr, &slot.command_pool) != VK_SUCCESS) {
+            spdlog::error("failed to create recording command pool!");
+            std::exit(EXIT_FAILURE);
+        }
+
+        VkCommandBufferAllocateInfo alloc_info = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            nullptr, slot.command_pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1
+        };
+        if (vkAllocateCommandBuffers(vk_device_, &alloc_info, &slot.command_buffer) != VK_SUCCESS) {
+            spdlog::error("failed to allocate secondary command buffer!");
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    VkCommandBufferAllocateInfo skybox_alloc_info = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+        nullptr, recording_slots_[0].command_pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1
+    };
+    if (vkAllocateCommandBuffers(vk_device_, &skybox_alloc_info, &skybox_command_buffer_) != VK_SUCCESS) {
+        spdlog::error("failed to allocate secondary command buffer!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    spdlog::info("Recording scene draws on up to {} threads", recording_slots_.size());
+}
+
+void VulkanRenderer::DestroyRecordingResources() {
+    recording_pool_.reset();
+    for (const RecordingSlot &slot: recording_slots_)
+        if (slot.command_pool != VK_NULL_HANDLE)
+            vkDestroyCommandPool(vk_device_, slot.command_pool, nullptr);
+    recording_slots_.clear();
+    skybox_command_buffer_ = VK_NULL_HANDLE;
+}
+
 bool VulkanRenderer::BeginFrame() {
-    vkWaitForFences(vk_device_, 1, &vk_still_rendering_fence_, VK_TRUE, UINT64_MAX);
+    PROFILE_FUNCTION();
+    {
+        PROFILE_SCOPE("WaitForFence");
+        vkWaitForFences(vk_device_, 1, &vk_still_rendering_fence_, VK_TRUE, UINT64_MAX);
+    }
 
-    VkResult result = vkAcquireNextImageKHR(
-        vk_device_,
-        vk_swapchain_,
-        UINT64_MAX,
-        vk_image_available_signal_,
-        VK_NULL_HANDLE,
-        &current_image_index_);
+    VkResult result = VK_SUCCESS;
+    if (headless_) {
+        current_image_index_ = (current_image_index_ + 1) % kHeadlessImageCount;
+    } else {
+        PROFILE_SCOPE("AcquireNextImage");
+        result = vkAcquireNextImageKHR(
+            vk_device_,
+            vk_swapchain_,
+            UINT64_MAX,
+            vk_image_available_signal_,
+            VK_NULL_HANDLE,
+            &current_image_index_);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR) {
         RecreateSwapchain();
@@ -875,34 +1595,88 @@ bool VulkanRenderer::BeginFrame() {
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) throw std::runtime_error("failed to acquire next image!");
 
     vkResetFences(vk_device_, 1, &vk_still_rendering_fence_);
+    CollectTimestamps();
+    UpdatePostEffects();
     BeginCommands();
 
-    // Set model matrix for subsequent rendering
-    SetModelMatrix(glm::mat4(1.0f));
-
     return true;
 }
 
 void VulkanRenderer::EndFrame() {
+    PROFILE_FUNCTION();
+    draw_list_.FinalizeTransforms();
+    UpdateLightClusters();
+    UpdateShadows();
+    BuildFrameGraph();
     EndCommands();
+    shadow_cache_.MarkRendered();
+
+    VkResult submit_result;
+    if (UsesAsyncCompute()) {
+        // Scene, then the post chain on the compute queue, then the present
+        // pass; only the last one touches the swapchain image and the fence.
+        VkSubmitInfo scene_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        scene_info.commandBufferCount = 1;
+        scene_info.pCommandBuffers = &vk_command_buffer_;
+        scene_info.signalSemaphoreCount = 1;
+        scene_info.pSignalSemaphores = &vk_scene_finished_signal_;
+
+        VkPipelineStageFlags compute_wait_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        VkSubmitInfo compute_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        compute_info.waitSemaphoreCount = 1;
+        compute_info.pWaitSemaphores = &vk_scene_finished_signal_;
+        compute_info.pWaitDstStageMask = &compute_wait_stage;
+        compute_info.commandBufferCount = 1;
+        compute_info.pCommandBuffers = &vk_compute_command_buffer_;
+        compute_info.signalSemaphoreCount = 1;
+        compute_info.pSignalSemaphores = &vk_post_finished_signal_;
+
+        std::array present_waits = {vk_post_finished_signal_, vk_image_available_signal_};
+        std::array<VkPipelineStageFlags, 2> present_wait_stages = {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT
+        };
+        VkSubmitInfo present_pass_info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        present_pass_info.waitSemaphoreCount = headless_ ? 1 : 2;
+        present_pass_info.pWaitSemaphores = present_waits.data();
+        present_pass_info.pWaitDstStageMask = present_wait_stages.data();
+        present_pass_info.commandBufferCount = 1;
+        present_pass_info.pCommandBuffers = &vk_present_command_buffer_;
+        present_pass_info.signalSemaphoreCount = headless_ ? 0 : 1;
+        present_pass_info.pSignalSemaphores = &vk_render_finished_signal_;
+
+        PROFILE_SCOPE("QueueSubmit");
+        submit_result = vkQueueSubmit(vk_graphics_queue_, 1, &scene_info, VK_NULL_HANDLE);
+        if (submit_result == VK_SUCCESS)
+            submit_result = vkQueueSubmit(vk_compute_queue_, 1, &compute_info, VK_NULL_HANDLE);
+        if (submit_result == VK_SUCCESS)
+            submit_result = vkQueueSubmit(vk_graphics_queue_, 1, &present_pass_info, vk_still_rendering_fence_);
+    } else {
+        VkSubmitInfo submit_info = {};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSubmitInfo submit_info = {};
-    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-    VkPipelineStageFlags wait_stage_flags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-    submit_info.waitSemaphoreCount = 1;
-    submit_info.pWaitSemaphores = &vk_image_available_signal_;
-    submit_info.pWaitDstStageMask = &wait_stage_flags;
+        VkPipelineStageFlags wait_stage_flags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        submit_info.waitSemaphoreCount = headless_ ? 0 : 1;
+        submit_info.pWaitSemaphores = &vk_image_available_signal_;
+        submit_info.pWaitDstStageMask = &wait_stage_flags;
 
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers = &vk_command_buffer_;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &vk_command_buffer_;
 
-    submit_info.signalSemaphoreCount = 1;
-    submit_info.pSignalSemaphores = &vk_render_finished_signal_;
+        submit_info.signalSemaphoreCount = headless_ ? 0 : 1;
+        submit_info.pSignalSemaphores = &vk_render_finished_signal_;
 
-    VkResult submit_result = vkQueueSubmit(vk_graphics_queue_, 1, &submit_info, vk_still_rendering_fence_);
+        PROFILE_SCOPE("QueueSubmit");
+        submit_result = vkQueueSubmit(vk_graphics_queue_, 1, &submit_info, vk_still_rendering_fence_);
+    }
     if (submit_result != VK_SUCCESS) throw std::runtime_error("failed to submit queue!");
 
+    if (gpu_timestamps_.query_pool != VK_NULL_HANDLE) {
+        gpu_timestamps_.written[gpu_timestamps_.frame % GpuTimestamps::kFrames] = true;
+        gpu_timestamps_.frame++;
+    }
+
+    if (headless_) return;
+
     VkPresentInfoKHR present_info = {};
     present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
     present_info.waitSemaphoreCount = 1;
@@ -911,7 +1685,11 @@ void VulkanRenderer::EndFrame() {
     present_info.pSwapchains = &vk_swapchain_;
     present_info.pImageIndices = &current_image_index_;
 
-    VkResult result = vkQueuePresentKHR(vk_present_queue_, &present_info);
+    VkResult result;
+    {
+        PROFILE_SCOPE("QueuePresent");
+        result = vkQueuePresentKHR(vk_present_queue_, &present_info);
+    }
 
     if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
         RecreateSwapchain();
@@ -957,7 +1735,7 @@ BufferHandle VulkanRenderer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags
         nullptr, memory_requirements.size, chosen_memory_type
     };
 
-    VkResult allocation_result = vkAllocateMemory(vk_device_, &memory_allocate_info, nullptr, &buffer_handle.memory);
+    VkResult allocation_result = AllocateDeviceMemory(&memory_allocate_info, &buffer_handle.memory);
 
     if (allocation_result != VK_SUCCESS) throw std::runtime_error("failed to allocate buffer memory!");
 
@@ -967,14 +1745,25 @@ BufferHandle VulkanRenderer::CreateBuffer(VkDeviceSize size, VkBufferUsageFlags
 }
 
 BufferHandle VulkanRenderer::CreateIndexBuffer(std::vector<uint32_t> indices) {
+    // Indices that all fit in 16 bits go up as such, at half the size and bandwidth.
+    const bool narrow = std::ranges::all_of(indices, [](const std::uint32_t index) {
+        return index <= std::numeric_limits<std::uint16_t>::max();
+    });
+    std::vector<std::uint16_t> narrow_indices;
+    const void *source = indices.data();
     VkDeviceSize buffer_size = sizeof(uint32_t) * indices.size();
+    if (narrow) {
+        narrow_indices.assign(indices.begin(), indices.end());
+        source = narrow_indices.data();
+        buffer_size = sizeof(std::uint16_t) * narrow_indices.size();
+    }
     BufferHandle buffer_handle = CreateBuffer(
         buffer_size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     void *data;
     vkMapMemory(vk_device_, buffer_handle.memory, 0, buffer_size, 0, &data);
-    std::memcpy(data, indices.data(), buffer_size);
+    std::memcpy(data, source, buffer_size);
     vkUnmapMemory(vk_device_, buffer_handle.memory);
 
     BufferHandle gpu_handle = CreateBuffer(
@@ -990,45 +1779,31 @@ BufferHandle VulkanRenderer::CreateIndexBuffer(std::vector<uint32_t> indices) {
 
     DestroyBuffer(buffer_handle);
 
+    gpu_handle.index_type = narrow ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+
     return gpu_handle;
 }
 
 BufferHandle VulkanRenderer::CreateVertexBuffer(std::vector<oVertex> vertices) {
-    VkDeviceSize buffer_size = sizeof(oVertex) * vertices.size();
-    BufferHandle buffer_handle = CreateBuffer(
-        buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    void *data;
-    vkMapMemory(vk_device_, buffer_handle.memory, 0, buffer_size, 0, &data);
-    std::memcpy(data, vertices.data(), buffer_size);
-    vkUnmapMemory(vk_device_, buffer_handle.memory);
-
-    BufferHandle gpu_handle = CreateBuffer(
-        buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    VkCommandBuffer transient_commands = BeginTransientCommandBuffer();
-
-    VkBufferCopy copy_region = {0, 0, buffer_size};
-    vkCmdCopyBuffer(transient_commands, buffer_handle.buffer, gpu_handle.buffer, 1, &copy_region);
-
-    EndTransientCommandBuffer(transient_commands);
-
-    DestroyBuffer(buffer_handle);
+    return UploadVertexBuffer(vertices.data(), sizeof(oVertex) * vertices.size());
+}
 
-    return gpu_handle;
+BufferHandle VulkanRenderer::CreateVertexBuffer(const std::vector<oCompactVertex> &vertices) {
+    return UploadVertexBuffer(vertices.data(), sizeof(oCompactVertex) * vertices.size());
 }
 
 BufferHandle VulkanRenderer::CreateVertexBuffer(const std::vector<glm::vec3> &vertices) {
-    VkDeviceSize buffer_size = sizeof(glm::vec3) * vertices.size();
+    return UploadVertexBuffer(vertices.data(), sizeof(glm::vec3) * vertices.size());
+}
+
+BufferHandle VulkanRenderer::UploadVertexBuffer(const void *vertices, const VkDeviceSize buffer_size) {
     BufferHandle buffer_handle = CreateBuffer(
         buffer_size, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
     void *data;
     vkMapMemory(vk_device_, buffer_handle.memory, 0, buffer_size, 0, &data);
-    std::memcpy(data, vertices.data(), buffer_size);
+    std::memcpy(data, vertices, buffer_size);
     vkUnmapMemory(vk_device_, buffer_handle.memory);
 
     BufferHandle gpu_handle = CreateBuffer(
@@ -1047,82 +1822,526 @@ BufferHandle VulkanRenderer::CreateVertexBuffer(const std::vector<glm::vec3> &ve
     return gpu_handle;
 }
 
-void VulkanRenderer::DestroyBuffer(const BufferHandle buffer_handle) const {
+void VulkanRenderer::DestroyBuffer(const BufferHandle buffer_handle) {
     if (vk_device_ == VK_NULL_HANDLE) return;
 
     vkDeviceWaitIdle(vk_device_);
 
     if (buffer_handle.buffer != VK_NULL_HANDLE) {
+        draw_list_.ReleaseBuffer(buffer_handle.buffer);
         vkDestroyBuffer(vk_device_, buffer_handle.buffer, nullptr);
     }
 
     if (buffer_handle.memory != VK_NULL_HANDLE) {
-        vkFreeMemory(vk_device_, buffer_handle.memory, nullptr);
+        FreeDeviceMemory(buffer_handle.memory);
     }
 }
 
-void VulkanRenderer::RenderBuffer(BufferHandle buffer_handle, std::uint32_t vertex_count) {
-    VkDeviceSize offset = 0;
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
-                            0, 1,
-                            &vk_uniform_set_, 0, nullptr);
-    vkCmdBindVertexBuffers(vk_command_buffer_, 0, 1, &buffer_handle.buffer, &offset);
-    vkCmdDraw(vk_command_buffer_, vertex_count, 1, 0, 0);
-    SetModelMatrix(glm::mat4(1.0f));
+VkResult VulkanRenderer::AllocateDeviceMemory(const VkMemoryAllocateInfo *allocate_info, VkDeviceMemory *memory) {
+    const VkResult result = vkAllocateMemory(vk_device_, allocate_info, nullptr, memory);
+    if (result != VK_SUCCESS) return result;
+
+    allocation_sizes_[*memory] = allocate_info->allocationSize;
+    memory_stats_.allocated_bytes += allocate_info->allocationSize;
+    memory_stats_.peak_bytes = std::max(memory_stats_.peak_bytes, memory_stats_.allocated_bytes);
+    memory_stats_.allocation_count++;
+    return result;
 }
 
-void VulkanRenderer::RenderIndexedBuffer(BufferHandle vertex_buffer_handle, BufferHandle index_buffer_handle,
-                                         std::uint32_t index_count, std::int32_t index_offset) {
-    VkDeviceSize offset = 0;
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
-                            0, 2,
-                            std::array{vk_uniform_set_, vk_bp_set_}.data(), 0, nullptr);
-    vkCmdBindVertexBuffers(vk_command_buffer_, 0, 1, &vertex_buffer_handle.buffer, &offset);
-    vkCmdBindIndexBuffer(vk_command_buffer_, index_buffer_handle.buffer, 0, VK_INDEX_TYPE_UINT32);
-    vkCmdDrawIndexed(vk_command_buffer_, index_count, 1, 0, index_offset, 0);
-    SetModelMatrix(glm::mat4(1.0f));
+void VulkanRenderer::FreeDeviceMemory(VkDeviceMemory memory) const {
+    if (const auto it = allocation_sizes_.find(memory); it != allocation_sizes_.end()) {
+        memory_stats_.allocated_bytes -= it->second;
+        memory_stats_.allocation_count--;
+        allocation_sizes_.erase(it);
+    }
+    vkFreeMemory(vk_device_, memory, nullptr);
 }
 
 void VulkanRenderer::RenderModel(BufferHandle vertex_buffer, BufferHandle index_buffer, const std::vector<Mesh> &meshes,
-                                 std::vector<TextureHandle> &textures, std::vector<Material_UBO> material_ubos,
-                                 const glm::mat4 &modelMatrix) {
-    int offset = 0;
-    VkDeviceSize dOffset = 0;
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
+                                 const std::vector<TextureHandle> &textures,
+                                 const std::vector<Material_UBO> &material_ubos, const glm::mat4 &modelMatrix,
+                                 const PositionDecode &position_decode) {
+    // There is a single material block, read when the frame executes, so only
+    // the last write reaches the GPU; doing it here keeps the workers off it.
+    if (!meshes.empty()) SetUbo(material_ubos[meshes.back().materialId]);
+
+    const std::uint32_t transform = draw_list_.AddTransform(modelMatrix, position_decode);
+    const VkPipeline pipeline = depth_prepass_ ? main_equal_pipeline_ : main_pipeline_helper_.pipeline;
+    std::uint32_t first_index = 0;
+    for (const auto &[indices, materialId, baseVertex]: meshes) {
+        const auto index_count = static_cast<std::uint32_t>(indices.size());
+        const TextureHandle &texture = textures[materialId];
+        draw_list_.Add(pipeline, bindless_textures_ ? vk_bindless_set_ : texture.descriptor_set,
+                       texture.texture_index, vertex_buffer.buffer, index_buffer.buffer, index_buffer.index_type,
+                       first_index, index_count, static_cast<std::int32_t>(baseVertex), transform);
+        first_index += index_count;
+    }
+}
+
+void VulkanRenderer::RecordSceneDraws(VkCommandBuffer command_buffer, const std::span<const DrawPacket> packets,
+                                      RenderStats &stats) const {
+    if (packets.empty()) return;
+
+    // Camera, material and lights are the same for every packet.
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
                             0, 2,
                             std::array{vk_uniform_set_, vk_bp_set_}.data(), 0, VK_NULL_HANDLE);
-
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
                             3, 1,
                             std::array{vk_lights_set_}.data(), 0, VK_NULL_HANDLE);
-    vkCmdBindVertexBuffers(vk_command_buffer_, 0, 1, &vertex_buffer.buffer, &dOffset);
-    vkCmdBindIndexBuffer(vk_command_buffer_, index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-    SetModelMatrix(modelMatrix);
-    for (const auto &[indices, materialId]: meshes) {
-        SetTexture(textures[materialId]);
-        SetUbo(material_ubos[materialId]);
-        vkCmdDrawIndexed(vk_command_buffer_, indices.size(), 1, offset, 0, 0);
-        offset += static_cast<int>(indices.size());
+    stats.binds.descriptor_sets += 2;
+
+    // Only what differs from the previous packet gets bound.
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkDescriptorSet texture_set = VK_NULL_HANDLE;
+    std::uint32_t texture_index = kNoTextureIndex;
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    std::uint32_t transform = UINT32_MAX;
+    for (const DrawPacket &packet: packets) {
+        if (packet.pipeline != pipeline) {
+            vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+            pipeline = packet.pipeline;
+            stats.binds.pipelines++;
+        }
+        if (packet.texture_set != texture_set) {
+            vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                    main_pipeline_helper_.pipeline_layout, 2, 1,
+                                    &packet.texture_set, 0, VK_NULL_HANDLE);
+            texture_set = packet.texture_set;
+            stats.binds.descriptor_sets++;
+        }
+        if (bindless_textures_ && packet.texture_index != texture_index) {
+            vkCmdPushConstants(command_buffer, main_pipeline_helper_.pipeline_layout, VK_SHADER_STAGE_FRAGMENT_BIT,
+                               kTextureIndexPushOffset, sizeof(std::uint32_t), &packet.texture_index);
+            texture_index = packet.texture_index;
+            stats.binds.push_constants++;
+        }
+        if (packet.vertex_buffer != vertex_buffer) {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &packet.vertex_buffer, &offset);
+            vertex_buffer = packet.vertex_buffer;
+            stats.binds.vertex_buffers++;
+        }
+        if (packet.index_buffer != index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, packet.index_buffer, 0, packet.index_type);
+            index_buffer = packet.index_buffer;
+            stats.binds.index_buffers++;
+        }
+        if (packet.transform != transform) {
+            SetModelTransform(command_buffer, draw_list_.GetTransform(packet.transform));
+            transform = packet.transform;
+            stats.binds.push_constants++;
+        }
+        vkCmdDrawIndexed(command_buffer, packet.index_count, 1, packet.first_index, packet.vertex_offset, 0);
+        stats.draw_calls++;
+        stats.triangles += packet.index_count / 3;
     }
 }
 
-void VulkanRenderer::SetModelMatrix(const glm::mat4 &matrix) const {
-    vkCmdPushConstants(vk_command_buffer_, main_pipeline_helper_.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
-                       sizeof(glm::mat4),
-                       &matrix);
-}
-
-void VulkanRenderer::SetViewProjection(glm::mat4 matrix, glm::mat4 projection, glm::vec3 cameraPos) {
+void VulkanRenderer::RecordDepthPrepass(VkCommandBuffer command_buffer, const std::span<const DrawPacket> packets,
+                                        RenderStats &stats) const {
+    if (packets.empty()) return;
+
+    // Only the camera is read; textures and lights wait for the color pass.
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, depth_prepass_pipeline_helper_.pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, main_pipeline_helper_.pipeline_layout,
+                            0, 1, &vk_uniform_set_, 0, VK_NULL_HANDLE);
+    stats.binds.pipelines++;
+    stats.binds.descriptor_sets++;
+
+    VkBuffer vertex_buffer = VK_NULL_HANDLE;
+    VkBuffer index_buffer = VK_NULL_HANDLE;
+    std::uint32_t transform = UINT32_MAX;
+    for (const DrawPacket &packet: packets) {
+        if (packet.vertex_buffer != vertex_buffer) {
+            VkDeviceSize offset = 0;
+            vkCmdBindVertexBuffers(command_buffer, 0, 1, &packet.vertex_buffer, &offset);
+            vertex_buffer = packet.vertex_buffer;
+            stats.binds.vertex_buffers++;
+        }
+        if (packet.index_buffer != index_buffer) {
+            vkCmdBindIndexBuffer(command_buffer, packet.index_buffer, 0, packet.index_type);
+            index_buffer = packet.index_buffer;
+            stats.binds.index_buffers++;
+        }
+        if (packet.transform != transform) {
+            SetModelTransform(command_buffer, draw_list_.GetTransform(packet.transform));
+            transform = packet.transform;
+            stats.binds.push_constants++;
+        }
+        vkCmdDrawIndexed(command_buffer, packet.index_count, 1, packet.first_index, packet.vertex_offset, 0);
+        stats.prepass_draw_calls++;
+    }
+}
+
+void VulkanRenderer::SetModelTransform(VkCommandBuffer command_buffer, const DrawTransform &transform) const {
+    vkCmdPushConstants(command_buffer, main_pipeline_helper_.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(DrawTransform),
+                       &transform);
+}
+
+void VulkanRenderer::SetViewProjection(glm::mat4 matrix, glm::mat4 projection, glm::vec3 cameraPos) {
+    view_matrix_ = matrix;
+    projection_matrix_ = projection;
     UniformTransformations transformations{matrix, projection, cameraPos};
     std::memcpy(uniform_buffer_location_, &transformations, sizeof(UniformTransformations));
 }
 
-void VulkanRenderer::SetUbo(Material_UBO &material_ubos) const {
+void VulkanRenderer::SetUbo(const Material_UBO &material_ubos) const {
     memcpy(bp_buffer_location_, &material_ubos, sizeof(Material_UBO));
 }
 
-void VulkanRenderer::SetLightsUBO(GlobalLighting *global_lighting) {
-    memcpy(global_lights_buffer_location_, global_lighting, sizeof(GlobalLighting));
+void VulkanRenderer::SetLights(const GlobalLighting *global_lighting) {
+    lights_ = global_lighting->lights;
+    sun_ = global_lighting->sun;
+
+    // The first few shadow casters get a slot in the point shadow map.
+    shadowed_lights_.clear();
+    for (LightUBO &light: lights_)
+        light.diffuse.w = -1.0f;
+    for (const std::uint32_t caster: global_lighting->shadow_casters) {
+        if (shadowed_lights_.size() == kMaxShadowedPointLights) break;
+        lights_[caster].diffuse.w = static_cast<float>(shadowed_lights_.size());
+        shadowed_lights_.push_back(lights_[caster]);
+    }
+}
+
+void *VulkanRenderer::ReserveStorage(StorageBuffer &storage, const std::uint32_t binding, const VkDeviceSize size) {
+    if (size <= storage.capacity) return storage.data;
+
+    // Only called between the frame fence and recording, so the old buffer
+    // and the set pointing at it are no longer in use.
+    DestroyStorage(storage);
+    storage.capacity = std::max(size, storage.capacity * 2);
+    storage.handle = CreateBuffer(storage.capacity, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    vkMapMemory(vk_device_, storage.handle.memory, 0, storage.capacity, 0, &storage.data);
+
+    if (vk_lights_set_ != VK_NULL_HANDLE) {
+        VkDescriptorBufferInfo buffer_info = {storage.handle.buffer, 0, VK_WHOLE_SIZE};
+        VkWriteDescriptorSet write = {
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, vk_lights_set_, binding, 0,
+            1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr, &buffer_info
+        };
+        vkUpdateDescriptorSets(vk_device_, 1, &write, 0, nullptr);
+    }
+    return storage.data;
+}
+
+void VulkanRenderer::DestroyStorage(StorageBuffer &storage) {
+    if (storage.data) {
+        vkUnmapMemory(vk_device_, storage.handle.memory);
+        storage.data = nullptr;
+    }
+    DestroyBuffer(storage.handle);
+    storage = {};
+}
+
+void VulkanRenderer::UpdateLightClusters() {
+    PROFILE_FUNCTION();
+    light_clusters_.Build(lights_, view_matrix_, projection_matrix_,
+                          {static_cast<float>(vk_extent_.width), static_cast<float>(vk_extent_.height)});
+
+    // An empty storage buffer cannot be bound, so every buffer keeps at least one element.
+    const std::size_t lights_size = std::max<std::size_t>(lights_.size(), 1) * sizeof(LightUBO);
+    std::ranges::copy(lights_, static_cast<LightUBO *>(ReserveStorage(light_buffer_, 0, lights_size)));
+
+    const std::span<const glm::uvec2> ranges = light_clusters_.GetRanges();
+    auto *cluster_data = static_cast<std::uint8_t *>(
+        ReserveStorage(cluster_buffer_, 1, sizeof(ClusterGridHeader) + ranges.size_bytes()));
+    std::memcpy(cluster_data, &light_clusters_.GetHeader(), sizeof(ClusterGridHeader));
+    std::memcpy(cluster_data + sizeof(ClusterGridHeader), ranges.data(), ranges.size_bytes());
+
+    const std::span<const std::uint32_t> indices = light_clusters_.GetIndices();
+    const VkDeviceSize indices_size = std::max<std::size_t>(indices.size_bytes(), sizeof(std::uint32_t));
+    std::ranges::copy(indices, static_cast<std::uint32_t *>(ReserveStorage(light_index_buffer_, 2, indices_size)));
+}
+
+VkFormat VulkanRenderer::FindShadowFormat() const {
+    // Shadow maps are sampled with a filtered depth comparison.
+    const std::array<VkFormat, 2> candidates = {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM};
+    constexpr VkFormatFeatureFlags required =
+            VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+
+    for (VkFormat format: candidates) {
+        VkFormatProperties props;
+        vkGetPhysicalDeviceFormatProperties(vk_physical_device_, format, &props);
+
+        if ((props.optimalTilingFeatures & required) == required) {
+            return format;
+        }
+    }
+
+    throw std::runtime_error("Failed to find supported shadow map format!");
+}
+
+void VulkanRenderer::CreateShadowResources() {
+    shadow_format_ = FindShadowFormat();
+
+    if (!dynamic_rendering_) {
+        // The frame graph does the layout transitions, so the
+        // attachment stays in the attachment layout throughout.
+        VkAttachmentDescription depth_attachment = {
+            0, shadow_format_, VK_SAMPLE_COUNT_1_BIT, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE,
+            VK_ATTACHMENT_LOAD_OP_DONT_CARE, VK_ATTACHMENT_STORE_OP_DONT_CARE,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+        };
+        VkAttachmentReference depth_reference = {0, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL};
+
+        VkSubpassDescription subpass = {};
+        subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        subpass.pDepthStencilAttachment = &depth_reference;
+
+        VkRenderPassCreateInfo render_pass_info = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO, nullptr, 0, 1, &depth_attachment, 1, &subpass
+        };
+        if (vkCreateRenderPass(vk_device_, &render_pass_info, nullptr, &shadow_render_pass_) != VK_SUCCESS) {
+            spdlog::error("Failed to create shadow render pass!");
+            std::exit(EXIT_FAILURE);
+        }
+    }
+
+    CreateShadowMap(cascade_shadow_map_, kCascadeShadowSize, kShadowCascades);
+    CreateShadowMap(point_shadow_map_, kPointShadowSize, kPointShadowLayers);
+
+    // Outside a map counts as lit: the white border compares as the far plane.
+    VkSamplerCreateInfo sampler_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sampler_info.magFilter = VK_FILTER_LINEAR;
+    sampler_info.minFilter = VK_FILTER_LINEAR;
+    sampler_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+    sampler_info.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+    sampler_info.compareEnable = VK_TRUE;
+    sampler_info.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    if (vkCreateSampler(vk_device_, &sampler_info, nullptr, &shadow_sampler_) != VK_SUCCESS) {
+        spdlog::error("Failed to create shadow sampler!");
+        std::exit(EXIT_FAILURE);
+    }
+
+    shadow_uniform_buffer_ = CreateBuffer(sizeof(ShadowUniforms), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                                          VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    vkMapMemory(vk_device_, shadow_uniform_buffer_.memory, 0, sizeof(ShadowUniforms), 0, &shadow_uniform_location_);
+    std::memcpy(shadow_uniform_location_, &shadow_cache_.GetUniforms(), sizeof(ShadowUniforms));
+
+    // Model matrix where the main pipeline has it, then the light's view-projection.
+    shadow_pipeline_helper_ = {
+        {"shaders/shadow.vert.spv"}, {oVertex::GetBindingDescription()}, oVertex::GetAttributeDescriptions(),
+        VK_CULL_MODE_NONE, {true, true, VK_COMPARE_OP_LESS_OR_EQUAL},
+        {{VK_SHADER_STAGE_VERTEX_BIT, 0, 2 * sizeof(glm::mat4)}}, {}
+    };
+    shadow_pipeline_helper_.render_pass = shadow_render_pass_;
+    shadow_pipeline_helper_.depth_format = shadow_format_;
+    shadow_pipeline_helper_.depth_bias = {1.25f, 1.75f};
+    shadow_pipeline_helper_.color_attachment_count = 0;
+    CreatePipeline(shadow_pipeline_helper_);
+}
+
+void VulkanRenderer::CreateShadowMap(ShadowMap &shadow_map, const std::uint32_t size, const std::uint32_t layers) {
+    shadow_map.extent = {size, size};
+
+    VkImageCreateInfo image_info{};
+    image_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_info.imageType = VK_IMAGE_TYPE_2D;
+    image_info.format = shadow_format_;
+    image_info.extent = {size, size, 1};
+    image_info.mipLevels = 1;
+    image_info.arrayLayers = layers;
+    image_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_info.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    image_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(vk_device_, &image_info, nullptr, &shadow_map.image) != VK_SUCCESS)
+        throw std::runtime_error("failed to create shadow map image!");
+
+    VkMemoryRequirements mem_requirements = {};
+    vkGetImageMemoryRequirements(vk_device_, shadow_map.image, &mem_requirements);
+
+    VkMemoryAllocateInfo allocation_info = {
+        VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO, nullptr, mem_requirements.size,
+        FindMemoryType(mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+    };
+    if (AllocateDeviceMemory(&allocation_info, &shadow_map.memory) != VK_SUCCESS)
+        throw std::runtime_error("failed to allocate shadow map memory!");
+    vkBindImageMemory(vk_device_, shadow_map.image, shadow_map.memory, 0);
+
+    VkImageViewCreateInfo view_info{};
+    view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    view_info.image = shadow_map.image;
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+    view_info.format = shadow_format_;
+    view_info.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, layers};
+    if (vkCreateImageView(vk_device_, &view_info, nullptr, &shadow_map.view) != VK_SUCCESS)
+        throw std::runtime_error("failed to create shadow map view!");
+
+    view_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    shadow_map.layer_views.resize(layers);
+    for (std::uint32_t layer = 0; layer < layers; ++layer) {
+        view_info.subresourceRange = {VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, layer, 1};
+        if (vkCreateImageView(vk_device_, &view_info, nullptr, &shadow_map.layer_views[layer]) != VK_SUCCESS)
+            throw std::runtime_error("failed to create shadow map layer view!");
+    }
+
+    // The frame graph imports the map ready to sample at the start of every
+    // frame. Its contents are undefined until a view renders each layer.
+    VkCommandBuffer command_buffer = BeginTransientCommandBuffer();
+    ImageBarrier barrier = MakeImageBarrier(shadow_map.image, VK_IMAGE_LAYOUT_UNDEFINED,
+                                            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_NONE,
+                                            VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
+    barrier.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+    barrier.layer_count = layers;
+    RecordImageBarriers(command_buffer, std::span(&barrier, 1), synchronization2_);
+    EndTransientCommandBuffer(command_buffer);
+
+    if (shadow_render_pass_ == VK_NULL_HANDLE) return;
+
+    shadow_map.framebuffers.resize(layers);
+    for (std::uint32_t layer = 0; layer < layers; ++layer) {
+        VkFramebufferCreateInfo framebuffer_info = {
+            VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO, nullptr, 0, shadow_render_pass_, 1,
+            &shadow_map.layer_views[layer], size, size, 1
+        };
+        if (vkCreateFramebuffer(vk_device_, &framebuffer_info, nullptr, &shadow_map.framebuffers[layer]) != VK_SUCCESS)
+            throw std::runtime_error("failed to create shadow map framebuffer!");
+    }
+}
+
+void VulkanRenderer::DestroyShadowMap(ShadowMap &shadow_map) const {
+    for (VkFramebuffer framebuffer: shadow_map.framebuffers)
+        vkDestroyFramebuffer(vk_device_, framebuffer, nullptr);
+    for (VkImageView view: shadow_map.layer_views)
+        vkDestroyImageView(vk_device_, view, nullptr);
+    if (shadow_map.view != VK_NULL_HANDLE)
+        vkDestroyImageView(vk_device_, shadow_map.view, nullptr);
+    if (shadow_map.image != VK_NULL_HANDLE)
+        vkDestroyImage(vk_device_, shadow_map.image, nullptr);
+    if (shadow_map.memory != VK_NULL_HANDLE)
+        FreeDeviceMemory(shadow_map.memory);
+    shadow_map = {};
+}
+
+void VulkanRenderer::DestroyShadowResources() {
+    DestroyShadowMap(cascade_shadow_map_);
+    DestroyShadowMap(point_shadow_map_);
+
+    if (shadow_uniform_location_) {
+        vkUnmapMemory(vk_device_, shadow_uniform_buffer_.memory);
+        shadow_uniform_location_ = nullptr;
+    }
+    DestroyBuffer(shadow_uniform_buffer_);
+
+    if (shadow_sampler_ != VK_NULL_HANDLE)
+        vkDestroySampler(vk_device_, shadow_sampler_, nullptr);
+    if (shadow_pipeline_helper_.pipeline != VK_NULL_HANDLE)
+        vkDestroyPipeline(vk_device_, shadow_pipeline_helper_.pipeline, nullptr);
+    if (shadow_pipeline_helper_.pipeline_layout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(vk_device_, shadow_pipeline_helper_.pipeline_layout, nullptr);
+    if (shadow_render_pass_ != VK_NULL_HANDLE)
+        vkDestroyRenderPass(vk_device_, shadow_render_pass_, nullptr);
+}
+
+void VulkanRenderer::UpdateShadows() {
+    PROFILE_FUNCTION();
+    shadow_cache_.Update(sun_, shadowed_lights_, view_matrix_, projection_matrix_, shadow_caster_revision_);
+    std::memcpy(shadow_uniform_location_, &shadow_cache_.GetUniforms(), sizeof(ShadowUniforms));
+}
+
+RenderGraphResource VulkanRenderer::AddShadowPass(RenderGraph &graph, const std::string &name,
+                                                  const ShadowMap &shadow_map,
+                                                  const std::span<const ShadowView> views) {
+    // Between frames the map is ready to sample, last read by the previous
+    // frame's scene pass. Cached layers keep their contents through the
+    // transitions, as the layout never passes through UNDEFINED.
+    const auto layers = static_cast<std::uint32_t>(shadow_map.layer_views.size());
+    const RenderGraphResource map = graph.ImportImage(
+        name, shadow_map.image, shadow_map.view, {shadow_format_, shadow_map.extent, VK_IMAGE_ASPECT_DEPTH_BIT, layers},
+        {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT});
+    if (std::ranges::none_of(views, &ShadowView::dirty)) return map;
+
+    graph.AddPass(name, RenderGraphPassType::Graphics)
+        .Write(map, RenderGraphAccess::DepthAttachment)
+        .Execute([this, &shadow_map, views](VkCommandBuffer, const RenderGraph &) {
+            RecordShadowMap(shadow_map, views);
+        });
+    return map;
+}
+
+void VulkanRenderer::RecordShadowMap(const ShadowMap &shadow_map, const std::span<const ShadowView> views) {
+    const VkRect2D area = {{0, 0}, shadow_map.extent};
+    const VkViewport viewport = {
+        0.0f, 0.0f, static_cast<float>(area.extent.width), static_cast<float>(area.extent.height), 0.0f, 1.0f
+    };
+    VkClearValue clear_value = {};
+    clear_value.depthStencil = {1.0f, 0};
+
+    const std::span<const DrawPacket> packets = draw_list_.GetPackets();
+    const VkPipelineLayout layout = shadow_pipeline_helper_.pipeline_layout;
+    for (std::uint32_t layer = 0; layer < views.size(); ++layer) {
+        if (!views[layer].dirty) continue;
+
+        if (dynamic_rendering_) {
+            VkRenderingAttachmentInfo depth_attachment{};
+            depth_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+            depth_attachment.imageView = shadow_map.layer_views[layer];
+            depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+            depth_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+            depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            depth_attachment.clearValue = clear_value;
+
+            VkRenderingInfo rendering_info{};
+            rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+            rendering_info.renderArea = area;
+            rendering_info.layerCount = 1;
+            rendering_info.pDepthAttachment = &depth_attachment;
+            vkCmdBeginRendering(vk_command_buffer_, &rendering_info);
+        } else {
+            VkRenderPassBeginInfo render_pass_info{};
+            render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+            render_pass_info.renderPass = shadow_render_pass_;
+            render_pass_info.framebuffer = shadow_map.framebuffers[layer];
+            render_pass_info.renderArea = area;
+            render_pass_info.clearValueCount = 1;
+            render_pass_info.pClearValues = &clear_value;
+            vkCmdBeginRenderPass(vk_command_buffer_, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+        }
+        render_stats_.shadow_views++;
+
+        // Views without a light are just cleared.
+        if (views[layer].active && !packets.empty()) {
+            vkCmdBindPipeline(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pipeline_helper_.pipeline);
+            vkCmdSetViewport(vk_command_buffer_, 0, 1, &viewport);
+            vkCmdSetScissor(vk_command_buffer_, 0, 1, &area);
+            vkCmdPushConstants(vk_command_buffer_, layout, VK_SHADER_STAGE_VERTEX_BIT, sizeof(glm::mat4),
+                               sizeof(glm::mat4), &views[layer].view_proj);
+
+            VkBuffer vertex_buffer = VK_NULL_HANDLE;
+            VkBuffer index_buffer = VK_NULL_HANDLE;
+            for (const DrawPacket &packet: packets) {
+                if (packet.vertex_buffer != vertex_buffer) {
+                    VkDeviceSize offset = 0;
+                    vkCmdBindVertexBuffers(vk_command_buffer_, 0, 1, &packet.vertex_buffer, &offset);
+                    vertex_buffer = packet.vertex_buffer;
+                }
+                if (packet.index_buffer != index_buffer) {
+                    vkCmdBindIndexBuffer(vk_command_buffer_, packet.index_buffer, 0, packet.index_type);
+                    index_buffer = packet.index_buffer;
+                }
+                vkCmdPushConstants(vk_command_buffer_, layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4),
+                                   &draw_list_.GetTransform(packet.transform).model);
+                vkCmdDrawIndexed(vk_command_buffer_, packet.index_count, 1, packet.first_index,
+                                 packet.vertex_offset, 0);
+                render_stats_.shadow_draw_calls++;
+            }
+        }
+
+        if (dynamic_rendering_)
+            vkCmdEndRendering(vk_command_buffer_);
+        else
+            vkCmdEndRenderPass(vk_command_buffer_);
+    }
 }
 
 VkCommandBuffer VulkanRenderer::BeginTransientCommandBuffer() {
@@ -1168,11 +2387,10 @@ void VulkanRenderer::CreateUniformBuffers() {
 
     vkMapMemory(vk_device_, bp_buffer_handle_.memory, 0, bp_size, 0, &bp_buffer_location_);
 
-    VkDeviceSize lights_size = sizeof(GlobalLighting);
-    g_light_handle_ = CreateBuffer(lights_size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                                   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    vkMapMemory(vk_device_, g_light_handle_.memory, 0, lights_size, 0, &global_lights_buffer_location_);
+    // Grown as scenes add lights, see UpdateLightClusters.
+    ReserveStorage(light_buffer_, 0, 64 * sizeof(LightUBO));
+    ReserveStorage(cluster_buffer_, 1, sizeof(ClusterGridHeader) + kClusterCount * sizeof(glm::uvec2));
+    ReserveStorage(light_index_buffer_, 2, 1024 * sizeof(std::uint32_t));
 }
 
 void VulkanRenderer::CreateDescriptorSetLayouts() {
@@ -1184,9 +2402,13 @@ void VulkanRenderer::CreateDescriptorSetLayouts() {
         0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT
     };
 
-    VkDescriptorSetLayoutBinding lights_layout_binding = {
-        0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT
-    };
+    // Lights, cluster grid and light lists, then the shadow data and the two shadow maps.
+    std::array<VkDescriptorSetLayoutBinding, 6> lights_layout_bindings{};
+    for (std::uint32_t binding = 0; binding < 3; ++binding)
+        lights_layout_bindings[binding] = {binding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT};
+    lights_layout_bindings[3] = {3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT};
+    lights_layout_bindings[4] = {4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT};
+    lights_layout_bindings[5] = {5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT};
 
     VkDescriptorSetLayoutCreateInfo uniform_layout_info = {
         VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0, 1, &uniform_layout_binding
@@ -1197,7 +2419,8 @@ void VulkanRenderer::CreateDescriptorSetLayouts() {
     };
 
     VkDescriptorSetLayoutCreateInfo lights_layout_info = {
-        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0, 1, &lights_layout_binding
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast<std::uint32_t>(lights_layout_bindings.size()), lights_layout_bindings.data()
     };
 
     if (vkCreateDescriptorSetLayout(vk_device_, &uniform_layout_info, nullptr, &vk_uniform_set_layout_) != VK_SUCCESS) {
@@ -1228,14 +2451,41 @@ void VulkanRenderer::CreateDescriptorSetLayouts() {
         spdlog::error("Failed to create texture descriptor set layout!");
         exit(EXIT_FAILURE);
     }
+
+    if (!bindless_textures_) return;
+
+    // Slots are written as textures come and go, while the set may be bound
+    // by frames in flight, and the free ones are never written at all.
+    VkDescriptorSetLayoutBinding bindless_layout_binding = {
+        0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, bindless_capacity_, VK_SHADER_STAGE_FRAGMENT_BIT
+    };
+    VkDescriptorBindingFlags bindless_binding_flags =
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindless_flags_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO, nullptr, 1, &bindless_binding_flags
+    };
+    VkDescriptorSetLayoutCreateInfo bindless_layout_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO, &bindless_flags_info,
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT, 1, &bindless_layout_binding
+    };
+
+    if (vkCreateDescriptorSetLayout(vk_device_, &bindless_layout_info, nullptr, &vk_bindless_set_layout_) !=
+        VK_SUCCESS) {
+        spdlog::error("Failed to create bindless texture descriptor set layout!");
+        exit(EXIT_FAILURE);
+    }
 }
 
 void VulkanRenderer::CreateDescriptorPools() {
-    VkDescriptorPoolSize uniform_pool_sizes = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3};
+    std::array<VkDescriptorPoolSize, 3> uniform_pool_sizes = {{
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2}
+    }};
 
     VkDescriptorPoolCreateInfo pool_info = {
         VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        nullptr, 0, 3, 1, &uniform_pool_sizes
+        nullptr, 0, 3, static_cast<std::uint32_t>(uniform_pool_sizes.size()), uniform_pool_sizes.data()
     };
 
     if (vkCreateDescriptorPool(vk_device_, &pool_info, nullptr, &vk_uniform_pool_) != VK_SUCCESS) {
@@ -1257,6 +2507,20 @@ void VulkanRenderer::CreateDescriptorPools() {
         spdlog::error("Failed to create texture pool!");
         exit(EXIT_FAILURE);
     }
+
+    if (!bindless_textures_) return;
+
+    VkDescriptorPoolSize bindless_pool_size = {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, bindless_capacity_};
+
+    VkDescriptorPoolCreateInfo bindless_pool_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr,
+        VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT, 1, 1, &bindless_pool_size
+    };
+
+    if (vkCreateDescriptorPool(vk_device_, &bindless_pool_info, nullptr, &vk_bindless_pool_) != VK_SUCCESS) {
+        spdlog::error("Failed to create bindless texture pool!");
+        exit(EXIT_FAILURE);
+    }
 }
 
 void VulkanRenderer::CreateDescriptorSets() {
@@ -1304,16 +2568,51 @@ void VulkanRenderer::CreateDescriptorSets() {
         1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &bp_descriptor_buffer_info
     };
 
-    VkDescriptorBufferInfo gLights = {g_light_handle_.buffer, 0, sizeof(GlobalLighting)};
+    std::array lights_buffer_infos = {
+        VkDescriptorBufferInfo{light_buffer_.handle.buffer, 0, VK_WHOLE_SIZE},
+        VkDescriptorBufferInfo{cluster_buffer_.handle.buffer, 0, VK_WHOLE_SIZE},
+        VkDescriptorBufferInfo{light_index_buffer_.handle.buffer, 0, VK_WHOLE_SIZE}
+    };
 
-    VkWriteDescriptorSet gLightsWrite = {
+    VkWriteDescriptorSet lights_write = {
         VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, vk_lights_set_, 0, 0,
-        1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &gLights
+        static_cast<std::uint32_t>(lights_buffer_infos.size()), VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, nullptr,
+        lights_buffer_infos.data()
+    };
+
+    VkDescriptorBufferInfo shadow_buffer_info = {shadow_uniform_buffer_.buffer, 0, sizeof(ShadowUniforms)};
+
+    VkWriteDescriptorSet shadow_write = {
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, vk_lights_set_, 3, 0,
+        1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, nullptr, &shadow_buffer_info
+    };
+
+    std::array shadow_map_infos = {
+        VkDescriptorImageInfo{shadow_sampler_, cascade_shadow_map_.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+        VkDescriptorImageInfo{shadow_sampler_, point_shadow_map_.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+    };
+
+    VkWriteDescriptorSet shadow_maps_write = {
+        VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET, nullptr, vk_lights_set_, 4, 0,
+        static_cast<std::uint32_t>(shadow_map_infos.size()), VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        shadow_map_infos.data()
     };
 
-    std::array writes = {descriptor_write, bp_descriptor_write, gLightsWrite};
+    std::array writes = {descriptor_write, bp_descriptor_write, lights_write, shadow_write, shadow_maps_write};
 
     vkUpdateDescriptorSets(vk_device_, writes.size(), writes.data(), 0, nullptr);
+
+    if (!bindless_textures_) return;
+
+    VkDescriptorSetAllocateInfo bindless_set_allocate_info = {
+        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, vk_bindless_pool_, 1, &vk_bindless_set_layout_
+    };
+
+    result = vkAllocateDescriptorSets(vk_device_, &bindless_set_allocate_info, &vk_bindless_set_);
+    if (result != VK_SUCCESS) {
+        spdlog::error("Failed to allocate the bindless texture set!");
+        std::exit(EXIT_FAILURE);
+    }
 }
 
 void VulkanRenderer::CreateTextureSampler() {
@@ -1341,15 +2640,8 @@ void VulkanRenderer::CreateTextureSampler() {
     }
 }
 
-void VulkanRenderer::CreateDepthResources() {
-    VkFormat depth_format = VK_FORMAT_D32_SFLOAT;
-    depth_texture_ = CreateImage({vk_extent_.width, vk_extent_.height}, depth_format,
-                                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    depth_texture_.image_view = CreateImageView(depth_texture_.image, depth_format, VK_IMAGE_ASPECT_DEPTH_BIT);
-}
-
 TextureHandle VulkanRenderer::CreateTexture(const char *path) {
+    PROFILE_FUNCTION();
     glm::ivec2 image_extents;
     std::int32_t channels;
     std::vector<std::uint8_t> image_file_data = ReadFile(path);
@@ -1375,17 +2667,6 @@ TextureHandle VulkanRenderer::CreateTexture(const char *path) {
     CopyBufferToImage(staging_buffer.buffer, handle.image, image_extents);
     TransitionImageLayout(handle.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-    VkDescriptorSetAllocateInfo descriptor_set_info = {
-        VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-        nullptr, vk_texture_pool_, 1, &vk_texture_set_layout_
-    };
-
-    VkResult result = vkAllocateDescriptorSets(vk_device_, &descriptor_set_info, &handle.descriptor_set);
-    if (result != VK_SUCCESS) {
-        spdlog::error("Failed to allocate descriptor sets!");
-        exit(EXIT_FAILURE);
-    }
-
     handle.image_view = CreateImageView(handle.image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT);
 
     VkDescriptorImageInfo image_info = {
@@ -1394,9 +2675,25 @@ TextureHandle VulkanRenderer::CreateTexture(const char *path) {
 
     VkWriteDescriptorSet descriptor_write = {};
     descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptor_write.dstSet = handle.descriptor_set;
     descriptor_write.dstBinding = 0;
-    descriptor_write.dstArrayElement = 0;
+    if (bindless_textures_) {
+        handle.texture_index = AllocateTextureIndex();
+        descriptor_write.dstSet = vk_bindless_set_;
+        descriptor_write.dstArrayElement = handle.texture_index;
+    } else {
+        VkDescriptorSetAllocateInfo descriptor_set_info = {
+            VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            nullptr, vk_texture_pool_, 1, &vk_texture_set_layout_
+        };
+
+        VkResult result = vkAllocateDescriptorSets(vk_device_, &descriptor_set_info, &handle.descriptor_set);
+        if (result != VK_SUCCESS) {
+            spdlog::error("Failed to allocate descriptor sets!");
+            exit(EXIT_FAILURE);
+        }
+        descriptor_write.dstSet = handle.descriptor_set;
+        descriptor_write.dstArrayElement = 0;
+    }
     descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     descriptor_write.descriptorCount = 1;
     descriptor_write.pImageInfo = &image_info;
@@ -1411,12 +2708,19 @@ void VulkanRenderer::DestroyTexture(TextureHandle &handle) {
     if (vk_device_ == VK_NULL_HANDLE) return;
 
     vkDeviceWaitIdle(vk_device_);
+    draw_list_.ReleaseTexture(bindless_textures_ ? vk_bindless_set_ : handle.descriptor_set, handle.texture_index);
 
     if (handle.descriptor_set != VK_NULL_HANDLE && vk_texture_pool_ != VK_NULL_HANDLE) {
         vkFreeDescriptorSets(vk_device_, vk_texture_pool_, 1, &handle.descriptor_set);
         handle.descriptor_set = VK_NULL_HANDLE;
     }
 
+    // The device is idle, so the slot can be handed out again right away.
+    if (handle.texture_index != kNoTextureIndex) {
+        free_texture_indices_.push_back(handle.texture_index);
+        handle.texture_index = kNoTextureIndex;
+    }
+
     if (handle.image_view != VK_NULL_HANDLE) {
         vkDestroyImageView(vk_device_, handle.image_view, nullptr);
         handle.image_view = VK_NULL_HANDLE;
@@ -1428,59 +2732,50 @@ void VulkanRenderer::DestroyTexture(TextureHandle &handle) {
     }
 
     if (handle.memory != VK_NULL_HANDLE) {
-        vkFreeMemory(vk_device_, handle.memory, nullptr);
+        FreeDeviceMemory(handle.memory);
         handle.memory = VK_NULL_HANDLE;
     }
 }
 
-void VulkanRenderer::SetTexture(TextureHandle &handle) {
-    vkCmdBindDescriptorSets(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            main_pipeline_helper_.pipeline_layout, 2, 1,
-                            &handle.descriptor_set, 0, VK_NULL_HANDLE);
+std::uint32_t VulkanRenderer::AllocateTextureIndex() {
+    if (!free_texture_indices_.empty()) {
+        const std::uint32_t index = free_texture_indices_.back();
+        free_texture_indices_.pop_back();
+        return index;
+    }
+    if (next_texture_index_ == bindless_capacity_) {
+        spdlog::error("Bindless texture table is full ({} textures)!", bindless_capacity_);
+        std::exit(EXIT_FAILURE);
+    }
+    return next_texture_index_++;
 }
 
 void VulkanRenderer::TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout) {
     VkCommandBuffer local_command_buffer = BeginTransientCommandBuffer();
 
-    VkImageMemoryBarrier barrier = {};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
-
-    VkPipelineStageFlags src_stage_flags = 0;
-    VkPipelineStageFlags dst_stage_flags = 0;
+    ImageBarrier barrier = MakeImageBarrier(image, oldLayout, newLayout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+                                            VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE);
 
     if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        src_stage_flags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        dst_stage_flags = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        barrier.dst_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dst_stages = VK_PIPELINE_STAGE_2_COPY_BIT;
     } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout ==
                VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
-                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-        src_stage_flags = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        dst_stage_flags = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+        barrier.dst_access = VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+                             VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barrier.dst_stages = VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT;
     } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout ==
                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        src_stage_flags = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        dst_stage_flags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        barrier.src_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dst_access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+        barrier.src_stages = VK_PIPELINE_STAGE_2_COPY_BIT;
+        barrier.dst_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
     }
 
     if (newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-    else
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
 
-    vkCmdPipelineBarrier(local_command_buffer, src_stage_flags, dst_stage_flags, 0, 0,
-                         nullptr, 0, nullptr, 1, &barrier);
+    RecordImageBarriers(local_command_buffer, std::span(&barrier, 1), synchronization2_);
 
     EndTransientCommandBuffer(local_command_buffer);
 }
@@ -1534,7 +2829,7 @@ TextureHandle VulkanRenderer::CreateImage(glm::vec2 image_size, VkFormat image_f
         nullptr, mem_requirements.size, chosen_mem_type
     };
 
-    VkResult alloc_result = vkAllocateMemory(vk_device_, &allocation_info, nullptr, &handle.memory);
+    VkResult alloc_result = AllocateDeviceMemory(&allocation_info, &handle.memory);
 
     if (alloc_result != VK_SUCCESS) throw std::runtime_error("failed to allocate image memory!");
 
@@ -1544,6 +2839,8 @@ TextureHandle VulkanRenderer::CreateImage(glm::vec2 image_size, VkFormat image_f
 }
 
 void VulkanRenderer::RecreateSwapchain() {
+    if (headless_) return;
+
     glm::ivec2 size = window->GetFrameBufferSize();
     while (size.x == 0 || size.y == 0) {
         size = window->GetFrameBufferSize();
@@ -1556,6 +2853,10 @@ void VulkanRenderer::RecreateSwapchain() {
     CreateSwapChain();
     CreateImageViews();
     CreateFramebuffers();
+
+    // The scene and post targets follow the swapchain size.
+    DestroyPostProcessingTargets();
+    CreatePostProcessingTargets();
 }
 
 void VulkanRenderer::CleanupSwapchain() const {
@@ -1567,6 +2868,13 @@ void VulkanRenderer::CleanupSwapchain() const {
     for (VkImageView image_view: vk_swapchain_image_views_)
         vkDestroyImageView(vk_device_, image_view, nullptr);
 
+    if (headless_) {
+        for (VkImage image: vk_swapchain_images_)
+            vkDestroyImage(vk_device_, image, nullptr);
+        for (VkDeviceMemory memory: vk_offscreen_memory_)
+            FreeDeviceMemory(memory);
+    }
+
     if (vk_swapchain_ != VK_NULL_HANDLE) vkDestroySwapchainKHR(vk_device_, vk_swapchain_, nullptr);
 }
 
@@ -1577,6 +2885,15 @@ VulkanRenderer::VulkanRenderer(Window *window): Renderer(window, RendererType::V
     InitializeVulkan();
 }
 
+VulkanRenderer::VulkanRenderer(const std::uint32_t width, const std::uint32_t height)
+    : Renderer(nullptr, RendererType::VULKAN), headless_(true) {
+#if !defined(NDEBUG)
+    validation_ = true;
+#endif
+    vk_extent_ = {width, height};
+    InitializeVulkan();
+}
+
 VulkanRenderer::~VulkanRenderer() {
     VulkanRenderer::OnDestroy();
 }
@@ -1587,11 +2904,14 @@ bool VulkanRenderer::OnCreate() {
 }
 
 void VulkanRenderer::OnDestroy() {
+    // The last frame may still be resetting and writing the query pool, or
+    // running post passes; nothing is freed until every queue is idle.
+    if (vk_device_ != VK_NULL_HANDLE) vkDeviceWaitIdle(vk_device_);
+
     DestroyPostProcessingResources();
+    DestroyTimestampQueries();
 
     if (vk_device_ != VK_NULL_HANDLE) {
-        vkDeviceWaitIdle(vk_device_);
-
         // Cleanup skybox resources
         vkDestroyPipeline(vk_device_, skybox_.pipeline.pipeline, nullptr);
         vkDestroyPipelineLayout(vk_device_, skybox_.pipeline.pipeline_layout, nullptr);
@@ -1600,20 +2920,22 @@ void VulkanRenderer::OnDestroy() {
         vkDestroySampler(vk_device_, skybox_.sampler, nullptr);
         vkDestroyImageView(vk_device_, skybox_.view, nullptr);
         vkDestroyImage(vk_device_, skybox_.image, nullptr);
-        vkFreeMemory(vk_device_, skybox_.memory, nullptr);
-        DestroyBuffer(skybox_.vertex_buffer);
-        DestroyBuffer(skybox_.index_buffer);
+        FreeDeviceMemory(skybox_.memory);
 
         CleanupSwapchain();
 
-        DestroyTexture(depth_texture_);
-
         if (vk_texture_pool_ != VK_NULL_HANDLE)
             vkDestroyDescriptorPool(vk_device_, vk_texture_pool_, nullptr);
 
         if (vk_texture_set_layout_ != VK_NULL_HANDLE)
             vkDestroyDescriptorSetLayout(vk_device_, vk_texture_set_layout_, nullptr);
 
+        if (vk_bindless_pool_ != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(vk_device_, vk_bindless_pool_, nullptr);
+
+        if (vk_bindless_set_layout_ != VK_NULL_HANDLE)
+            vkDestroyDescriptorSetLayout(vk_device_, vk_bindless_set_layout_, nullptr);
+
         if (vk_texture_sampler_ != VK_NULL_HANDLE)
             vkDestroySampler(vk_device_, vk_texture_sampler_, nullptr);
 
@@ -1629,12 +2951,11 @@ void VulkanRenderer::OnDestroy() {
             vkUnmapMemory(vk_device_, bp_buffer_handle_.memory);
             bp_buffer_location_ = nullptr;
         }
-        if (global_lights_buffer_location_) {
-            vkUnmapMemory(vk_device_, g_light_handle_.memory);
-            global_lights_buffer_location_ = nullptr;
-        }
 
-        DestroyBuffer(g_light_handle_);
+        DestroyStorage(light_buffer_);
+        DestroyStorage(cluster_buffer_);
+        DestroyStorage(light_index_buffer_);
+        DestroyShadowResources();
         DestroyBuffer(uniform_buffer_);
         DestroyBuffer(bp_buffer_handle_);
 
@@ -1655,17 +2976,28 @@ void VulkanRenderer::OnDestroy() {
         if (vk_still_rendering_fence_ != VK_NULL_HANDLE)
             vkDestroyFence(vk_device_, vk_still_rendering_fence_, nullptr);
 
+        DestroyAsyncComputeResources();
+        DestroyRecordingResources();
+
         if (vk_command_pool_ != VK_NULL_HANDLE)
             vkDestroyCommandPool(vk_device_, vk_command_pool_, nullptr);
 
         if (main_pipeline_helper_.pipeline != VK_NULL_HANDLE)
             vkDestroyPipeline(vk_device_, main_pipeline_helper_.pipeline, nullptr);
+        if (depth_prepass_pipeline_helper_.pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(vk_device_, depth_prepass_pipeline_helper_.pipeline, nullptr);
+        if (main_equal_pipeline_ != VK_NULL_HANDLE)
+            vkDestroyPipeline(vk_device_, main_equal_pipeline_, nullptr);
         if (main_pipeline_helper_.pipeline_layout != VK_NULL_HANDLE)
             vkDestroyPipelineLayout(vk_device_, main_pipeline_helper_.pipeline_layout, nullptr);
 
         if (vk_render_pass_ != VK_NULL_HANDLE)
             vkDestroyRenderPass(vk_device_, vk_render_pass_, nullptr);
 
+        SavePipelineCache();
+        if (vk_pipeline_cache_ != VK_NULL_HANDLE)
+            vkDestroyPipelineCache(vk_device_, vk_pipeline_cache_, nullptr);
+
         vkDestroyDevice(vk_device_, nullptr);
     }
 
@@ -1688,23 +3020,25 @@ void VulkanRenderer::InitializeVulkan() {
     CreateSurface();
     PickPhysicalDevice();
     CreateLogicalDeviceAndQueues();
+    CreatePipelineCache();
     CreateSwapChain();
     CreateImageViews();
     CreateRenderPass();
+    CreatePostProcessingRenderPass();
     CreateDescriptorSetLayouts();
     CreateGraphicsPipeline();
-    CreateDepthResources();
     CreateFramebuffers();
     CreateCommandPool();
     CreateCommandBuffer();
     CreateSignals();
+    CreateAsyncComputeResources();
+    CreateRecordingResources();
+    CreateTimestampQueries();
     CreateUniformBuffers();
+    CreateShadowResources();
     CreateDescriptorPools();
     CreateDescriptorSets();
     CreateTextureSampler();
-    TransitionImageLayout(depth_texture_.image, VK_IMAGE_LAYOUT_UNDEFINED,
-                          VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
-
     CreatePostProcessingResources();
 }
 
@@ -1714,16 +3048,9 @@ void VulkanRenderer::CreateSkyboxResources() {
     // Create descriptor set layout
     CreateSkyboxDescriptorSetLayout();
 
-    // Create skybox pipeline
+    // Create skybox pipeline; its full-screen triangle needs no geometry
     CreateSkyboxPipeline();
 
-    // Create skybox geometry
-    auto vertices = CreateSkyboxVertices();
-    auto indices = CreateSkyboxIndices();
-
-    skybox_.vertex_buffer = CreateVertexBuffer(vertices);
-    skybox_.index_buffer = CreateIndexBuffer(indices);
-
     spdlog::info("Loading skybox textures from CN_Tower directory");
 
     CreateSkyboxImage(cubemap_);
@@ -1732,20 +3059,13 @@ void VulkanRenderer::CreateSkyboxResources() {
 }
 
 void VulkanRenderer::CreateSkyboxDescriptorSetLayout() {
-    // Create bindings for uniform buffer and cubemap sampler
-    std::array<VkDescriptorSetLayoutBinding, 2> bindings = {};
+    // Only the cubemap; the camera comes in as a push constant
+    std::array<VkDescriptorSetLayoutBinding, 1> bindings = {};
 
-    // Uniform buffer binding
-    bindings[0].binding = 0;
-    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    bindings[0].binding = 1;
+    bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     bindings[0].descriptorCount = 1;
-    bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
-
-    // Cubemap sampler binding
-    bindings[1].binding = 1;
-    bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    bindings[1].descriptorCount = 1;
-    bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
     VkDescriptorSetLayoutCreateInfo layout_info{};
     layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -1759,51 +3079,17 @@ void VulkanRenderer::CreateSkyboxDescriptorSetLayout() {
 
 void VulkanRenderer::CreateSkyboxPipeline() {
     skybox_.pipeline = {
-        {"shaders/skybox.vert.spv", "shaders/skybox.frag.spv"}, {Skybox::GetBindingDescription()},
-        Skybox::GetAttributeDescriptions(), VK_CULL_MODE_NONE, {true, false, VK_COMPARE_OP_LESS_OR_EQUAL},
+        {"shaders/skybox.vert.spv", "shaders/skybox.frag.spv"}, {}, {}, VK_CULL_MODE_NONE,
+        {true, false, VK_COMPARE_OP_LESS_OR_EQUAL},
         {{VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4)}}, {skybox_.descriptor_set_layout}
     };
+    skybox_.pipeline.render_pass = post_processing_.render_pass;
+    skybox_.pipeline.depth_format = FindDepthFormat();
     CreatePipeline(skybox_.pipeline);
 }
 
-std::vector<glm::vec3> VulkanRenderer::CreateSkyboxVertices() {
-    std::vector<glm::vec3> vertices = {
-        {-1.0f, 1.0f, -1.0f},
-        {-1.0f, -1.0f, -1.0f},
-        {1.0f, -1.0f, -1.0f},
-        {1.0f, 1.0f, -1.0f},
-        {-1.0f, 1.0f, 1.0f},
-        {-1.0f, -1.0f, 1.0f},
-        {1.0f, -1.0f, 1.0f},
-        {1.0f, 1.0f, 1.0f},
-    };
-
-    spdlog::info("Created skybox vertices: {} vertices", vertices.size());
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        spdlog::info("Vertex {}: ({}, {}, {})", i,
-                     vertices[i].x, vertices[i].y, vertices[i].z);
-    }
-
-    return vertices;
-}
-
-std::vector<uint32_t> VulkanRenderer::CreateSkyboxIndices() {
-    std::vector<uint32_t> indices = {
-        0, 1, 3, 3, 1, 2, // front
-        4, 5, 0, 0, 5, 1, // left
-        3, 2, 7, 7, 2, 6, // right
-        4, 0, 7, 7, 0, 3, // top
-        1, 5, 2, 2, 5, 6, // bottom
-        7, 6, 4, 4, 6, 5 // back
-    };
-
-    spdlog::info("Created skybox indices: {} indices ({} triangles)",
-                 indices.size(), indices.size() / 3);
-
-    return indices;
-}
-
 void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubemap_paths) {
+    PROFILE_FUNCTION();
     // Load all 6 faces first to get dimensions and create staging buffer
     int tex_width, tex_height, tex_channels;
     std::vector<stbi_uc *> pixels(6);
@@ -1866,7 +3152,7 @@ void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubema
     alloc_info.allocationSize = mem_requirements.size;
     alloc_info.memoryTypeIndex = FindMemoryType(mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    if (vkAllocateMemory(vk_device_, &alloc_info, nullptr, &skybox_.memory) != VK_SUCCESS) {
+    if (AllocateDeviceMemory(&alloc_info, &skybox_.memory) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate cubemap image memory!");
     }
 
@@ -1875,28 +3161,12 @@ void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubema
     // Transition image layout for copy
     VkCommandBuffer cmd = BeginTransientCommandBuffer();
 
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = skybox_.image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 6;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
+    ImageBarrier barrier = MakeImageBarrier(skybox_.image, VK_IMAGE_LAYOUT_UNDEFINED,
+                                            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_NONE,
+                                            VK_ACCESS_2_NONE, VK_PIPELINE_STAGE_2_COPY_BIT,
+                                            VK_ACCESS_2_TRANSFER_WRITE_BIT);
+    barrier.layer_count = 6;
+    RecordImageBarriers(cmd, std::span(&barrier, 1), synchronization2_);
 
     // Copy buffer to image
     std::array<VkBufferImageCopy, 6> copy_regions{};
@@ -1924,18 +3194,13 @@ void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubema
                            copy_regions.data());
 
     // Transition to shader read optimal
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
+    barrier.old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.src_stages = VK_PIPELINE_STAGE_2_COPY_BIT;
+    barrier.src_access = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+    barrier.dst_stages = VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT;
+    barrier.dst_access = VK_ACCESS_2_SHADER_SAMPLED_READ_BIT;
+    RecordImageBarriers(cmd, std::span(&barrier, 1), synchronization2_);
 
     EndTransientCommandBuffer(cmd);
 
@@ -1984,7 +3249,6 @@ void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubema
 
     // Create descriptor pool for skybox
     std::array pool_sizes = {
-        VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
         VkDescriptorPoolSize{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1}
     };
 
@@ -2009,93 +3273,44 @@ void VulkanRenderer::CreateSkyboxImage(const std::array<const char *, 6> &cubema
         throw std::runtime_error("Failed to allocate skybox descriptor set!");
     }
 
-    // Update descriptor set
-    std::array<VkWriteDescriptorSet, 2> descriptor_writes{};
-
-    // Uniform buffer descriptor
-    VkDescriptorBufferInfo uniform_buffer_info{};
-    uniform_buffer_info.buffer = uniform_buffer_.buffer;
-    uniform_buffer_info.offset = 0;
-    uniform_buffer_info.range = sizeof(UniformTransformations);
-
-    descriptor_writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptor_writes[0].dstSet = skybox_.descriptor_set;
-    descriptor_writes[0].dstBinding = 0;
-    descriptor_writes[0].dstArrayElement = 0;
-    descriptor_writes[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    descriptor_writes[0].descriptorCount = 1;
-    descriptor_writes[0].pBufferInfo = &uniform_buffer_info;
-
     // Cubemap sampler descriptor
     VkDescriptorImageInfo image_info{};
     image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     image_info.imageView = skybox_.view;
     image_info.sampler = skybox_.sampler;
 
-    descriptor_writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptor_writes[1].dstSet = skybox_.descriptor_set;
-    descriptor_writes[1].dstBinding = 1;
-    descriptor_writes[1].dstArrayElement = 0;
-    descriptor_writes[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    descriptor_writes[1].descriptorCount = 1;
-    descriptor_writes[1].pImageInfo = &image_info;
+    VkWriteDescriptorSet descriptor_write{};
+    descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptor_write.dstSet = skybox_.descriptor_set;
+    descriptor_write.dstBinding = 1;
+    descriptor_write.dstArrayElement = 0;
+    descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    descriptor_write.descriptorCount = 1;
+    descriptor_write.pImageInfo = &image_info;
 
-    vkUpdateDescriptorSets(vk_device_, descriptor_writes.size(), descriptor_writes.data(), 0, nullptr);
+    vkUpdateDescriptorSets(vk_device_, 1, &descriptor_write, 0, nullptr);
 
     // Cleanup staging buffer
     DestroyBuffer(staging_buffer);
 }
 
-void VulkanRenderer::RenderSkybox() {
-    static bool first_render = true;
-    if (first_render) {
-        spdlog::info("First skybox render call");
-        first_render = false;
-    }
-
-    vkCmdBindPipeline(vk_command_buffer_, VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_.pipeline.pipeline);
-
-    VkViewport viewport = GetViewport();
-    VkRect2D scissor = GetScissor();
-    vkCmdSetViewport(vk_command_buffer_, 0, 1, &viewport);
-    vkCmdSetScissor(vk_command_buffer_, 0, 1, &scissor);
-
-    VkDeviceSize offsets[] = {0};
-    vkCmdBindVertexBuffers(vk_command_buffer_, 0, 1, &skybox_.vertex_buffer.buffer, offsets);
-    vkCmdBindIndexBuffer(vk_command_buffer_, skybox_.index_buffer.buffer, 0, VK_INDEX_TYPE_UINT32);
-
-    // Get the current view-projection matrix but remove translation from view matrix
-    UniformTransformations transformations{};
-    memcpy(&transformations, uniform_buffer_location_, sizeof(UniformTransformations));
-
-    // Remove translation from view matrix to keep skybox centered on camera
-    glm::mat4 view = glm::mat4(glm::mat3(transformations.view)); // Use only rotation part of view matrix
-
-    // Update uniform buffer with skybox matrices
-    UniformTransformations skybox_transforms{
-        view,
-        transformations.projection
-    };
-    memcpy(uniform_buffer_location_, &skybox_transforms, sizeof(UniformTransformations));
-
-    if (first_render) {
-        spdlog::info("Binding skybox descriptor set: {}", (void *) skybox_.descriptor_set);
-    }
-
-    vkCmdBindDescriptorSets(vk_command_buffer_,
-                            VK_PIPELINE_BIND_POINT_GRAPHICS,
-                            skybox_.pipeline.pipeline_layout,
-                            0, 1, &skybox_.descriptor_set,
-                            0, nullptr);
-
-    if (first_render) {
-        spdlog::info("Drawing skybox with {} indices", 36);
-    }
-
-    vkCmdDrawIndexed(vk_command_buffer_, 36, 1, 0, 0, 0);
-
-    // Restore original transformations for rest of scene
-    memcpy(uniform_buffer_location_, &transformations, sizeof(UniformTransformations));
+void VulkanRenderer::RenderSkybox(VkCommandBuffer command_buffer) {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_.pipeline.pipeline);
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, skybox_.pipeline.pipeline_layout,
+                            0, 1, &skybox_.descriptor_set, 0, nullptr);
+
+    // Its own camera goes in a push constant, so the shared uniform buffer is
+    // never rewritten while a frame may be reading it.
+    const glm::mat4 inverse_view_projection = glm::inverse(projection_matrix_ * glm::mat4(glm::mat3(view_matrix_)));
+    vkCmdPushConstants(command_buffer, skybox_.pipeline.pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT, 0,
+                       sizeof(glm::mat4), &inverse_view_projection);
+
+    vkCmdDraw(command_buffer, 3, 1, 0, 0);
+    render_stats_.draw_calls++;
+    render_stats_.triangles += 1;
+    render_stats_.binds.pipelines++;
+    render_stats_.binds.descriptor_sets++;
+    render_stats_.binds.push_constants++;
 }
 
 VkFormat VulkanRenderer::FindDepthFormat() const {
@@ -2121,14 +3336,38 @@ bool VulkanRenderer::HasStencilComponent(VkFormat format) const {
     return format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT;
 }
 
+static const char *GetPostHeadShader(const PostEffectType type) {
+    switch (type) {
+        case PostEffectType::Pixelation: return "shaders/pixelation.frag.spv";
+        case PostEffectType::ChromaticAberration: return "shaders/chromab.frag.spv";
+        case PostEffectType::Bloom: return "shaders/bloom.frag.spv";
+        default: return "shaders/nopost.frag.spv";
+    }
+}
+
+static constexpr const char *kBloomDownShader = "shaders/bloom_down.frag.spv";
+static constexpr const char *kBloomUpShader = "shaders/bloom_up.frag.spv";
+
+// Every fragment post shader has a compute twin next to it.
+static std::string GetComputePostShader(const std::string &fragment_shader_path) {
+    constexpr std::string_view kFragmentSuffix = ".frag.spv";
+    return fragment_shader_path.substr(0, fragment_shader_path.size() - kFragmentSuffix.size()) + ".comp.spv";
+}
+
+static bool IsPointwiseEffect(const PostEffectType type) {
+    return type < PostEffectType::Passthrough;
+}
+
 void VulkanRenderer::CreatePostProcessingResources() {
-    CreatePostProcessingRenderPass();
-    CreatePostProcessingFramebuffer();
+    CreatePostChainRenderPass();
     CreatePostProcessingDescriptorSet();
+    CreatePostProcessingTargets();
     CreatePostProcessingPipeline();
 }
 
 void VulkanRenderer::CreatePostProcessingRenderPass() {
+    if (dynamic_rendering_) return;
+
     // Color attachment
     VkAttachmentDescription color_attachment{};
     color_attachment.format = vk_surface_format_.format;
@@ -2137,8 +3376,9 @@ void VulkanRenderer::CreatePostProcessingRenderPass() {
     color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
     color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    color_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color_attachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    // The frame graph does the transitions and the barriers around the pass.
+    color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
     // Depth attachment
     VkAttachmentDescription depth_attachment{};
@@ -2148,7 +3388,7 @@ void VulkanRenderer::CreatePostProcessingRenderPass() {
     depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depth_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depth_attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    depth_attachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
     depth_attachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
     VkAttachmentReference color_attachment_ref{};
@@ -2165,18 +3405,6 @@ void VulkanRenderer::CreatePostProcessingRenderPass() {
     subpass.pColorAttachments = &color_attachment_ref;
     subpass.pDepthStencilAttachment = &depth_attachment_ref;
 
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
-                              VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
-                               VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-    dependency.dependencyFlags = 0;
-
     std::array<VkAttachmentDescription, 2> attachments = {color_attachment, depth_attachment};
     VkRenderPassCreateInfo render_pass_info{};
     render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -2184,14 +3412,49 @@ void VulkanRenderer::CreatePostProcessingRenderPass() {
     render_pass_info.pAttachments = attachments.data();
     render_pass_info.subpassCount = 1;
     render_pass_info.pSubpasses = &subpass;
-    render_pass_info.dependencyCount = 1;
-    render_pass_info.pDependencies = &dependency;
 
     if (vkCreateRenderPass(vk_device_, &render_pass_info, nullptr, &post_processing_.render_pass) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create post-processing render pass!");
     }
 }
 
+void VulkanRenderer::CreatePostChainRenderPass() {
+    if (dynamic_rendering_) return;
+
+    // Compatible with vk_render_pass_ (one color attachment of the same
+    // format), so every effect pipeline can draw into either.
+    VkAttachmentDescription color_attachment{};
+    color_attachment.format = vk_surface_format_.format;
+    color_attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // Fully covered by the fullscreen triangle
+    color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    color_attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    color_attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    color_attachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    color_attachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference color_attachment_ref{};
+    color_attachment_ref.attachment = 0;
+    color_attachment_ref.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color_attachment_ref;
+
+    VkRenderPassCreateInfo render_pass_info{};
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.attachmentCount = 1;
+    render_pass_info.pAttachments = &color_attachment;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass;
+
+    if (vkCreateRenderPass(vk_device_, &render_pass_info, nullptr, &post_processing_.chain_render_pass) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("Failed to create post chain render pass!");
+    }
+}
+
 void VulkanRenderer::CreatePostProcessingFramebuffer() {
     // Create color image
     VkImageCreateInfo image_info{};
@@ -2221,7 +3484,7 @@ void VulkanRenderer::CreatePostProcessingFramebuffer() {
     alloc_info.allocationSize = mem_requirements.size;
     alloc_info.memoryTypeIndex = FindMemoryType(mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    if (vkAllocateMemory(vk_device_, &alloc_info, nullptr, &post_processing_.color_memory) != VK_SUCCESS) {
+    if (AllocateDeviceMemory(&alloc_info, &post_processing_.color_memory) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate post-processing image memory!");
     }
 
@@ -2240,7 +3503,7 @@ void VulkanRenderer::CreatePostProcessingFramebuffer() {
     alloc_info.allocationSize = mem_requirements.size;
     alloc_info.memoryTypeIndex = FindMemoryType(mem_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
-    if (vkAllocateMemory(vk_device_, &alloc_info, nullptr, &post_processing_.depth_memory) != VK_SUCCESS) {
+    if (AllocateDeviceMemory(&alloc_info, &post_processing_.depth_memory) != VK_SUCCESS) {
         throw std::runtime_error("Failed to allocate post-processing depth memory!");
     }
 
@@ -2252,6 +3515,8 @@ void VulkanRenderer::CreatePostProcessingFramebuffer() {
     post_processing_.depth_view = CreateImageView(post_processing_.depth_image, FindDepthFormat(),
                                                   VK_IMAGE_ASPECT_DEPTH_BIT);
 
+    if (dynamic_rendering_) return;
+
     // Create framebuffer
     std::array<VkImageView, 2> attachments = {
         post_processing_.color_view,
@@ -2278,7 +3543,7 @@ void VulkanRenderer::CreatePostProcessingDescriptorSet() {
     sampler_binding.binding = 0;
     sampler_binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
     sampler_binding.descriptorCount = 1;
-    sampler_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    sampler_binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
     VkDescriptorSetLayoutCreateInfo layout_info{};
     layout_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -2290,32 +3555,37 @@ void VulkanRenderer::CreatePostProcessingDescriptorSet() {
         throw std::runtime_error("Failed to create post-processing descriptor set layout!");
     }
 
-    // Create descriptor pool
+    VkDescriptorSetLayoutBinding storage_binding{};
+    storage_binding.binding = 0;
+    storage_binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    storage_binding.descriptorCount = 1;
+    storage_binding.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    layout_info.pBindings = &storage_binding;
+
+    if (vkCreateDescriptorSetLayout(vk_device_, &layout_info, nullptr, &post_processing_.storage_set_layout) !=
+        VK_SUCCESS) {
+        throw std::runtime_error("Failed to create post-processing storage set layout!");
+    }
+
+    // Create descriptor pool: one set for the scene color and one per post
+    // target. The compute graph has a pool of its own.
+    constexpr std::uint32_t kPostDescriptorSets = 1 + std::tuple_size_v<decltype(post_processing_.ping_pong)> +
+                                                  std::tuple_size_v<decltype(post_processing_.bloom)>;
+
     VkDescriptorPoolSize pool_size{};
     pool_size.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    pool_size.descriptorCount = 1;
+    pool_size.descriptorCount = kPostDescriptorSets;
 
     VkDescriptorPoolCreateInfo pool_info{};
     pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.poolSizeCount = 1;
     pool_info.pPoolSizes = &pool_size;
-    pool_info.maxSets = 1;
+    pool_info.maxSets = kPostDescriptorSets;
 
     if (vkCreateDescriptorPool(vk_device_, &pool_info, nullptr, &post_processing_.descriptor_pool) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create post-processing descriptor pool!");
     }
 
-    // Create descriptor set
-    VkDescriptorSetAllocateInfo alloc_info{};
-    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.descriptorPool = post_processing_.descriptor_pool;
-    alloc_info.descriptorSetCount = 1;
-    alloc_info.pSetLayouts = &post_processing_.descriptor_set_layout;
-
-    if (vkAllocateDescriptorSets(vk_device_, &alloc_info, &post_processing_.descriptor_set) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to allocate post-processing descriptor set!");
-    }
-
     // Create sampler
     VkSamplerCreateInfo sampler_info{};
     sampler_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -2328,16 +3598,28 @@ void VulkanRenderer::CreatePostProcessingDescriptorSet() {
     if (vkCreateSampler(vk_device_, &sampler_info, nullptr, &post_processing_.sampler) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create post-processing sampler!");
     }
+}
+
+VkDescriptorSet VulkanRenderer::CreatePostDescriptorSet(VkDescriptorPool pool, VkImageView view) const {
+    VkDescriptorSetAllocateInfo alloc_info{};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = 1;
+    alloc_info.pSetLayouts = &post_processing_.descriptor_set_layout;
+
+    VkDescriptorSet descriptor_set = VK_NULL_HANDLE;
+    if (vkAllocateDescriptorSets(vk_device_, &alloc_info, &descriptor_set) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to allocate post-processing descriptor set!");
+    }
 
-    // Update descriptor set
     VkDescriptorImageInfo image_info{};
     image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    image_info.imageView = post_processing_.color_view;
+    image_info.imageView = view;
     image_info.sampler = post_processing_.sampler;
 
     VkWriteDescriptorSet descriptor_write{};
     descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    descriptor_write.dstSet = post_processing_.descriptor_set;
+    descriptor_write.dstSet = descriptor_set;
     descriptor_write.dstBinding = 0;
     descriptor_write.dstArrayElement = 0;
     descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -2345,71 +3627,690 @@ void VulkanRenderer::CreatePostProcessingDescriptorSet() {
     descriptor_write.pImageInfo = &image_info;
 
     vkUpdateDescriptorSets(vk_device_, 1, &descriptor_write, 0, nullptr);
+    return descriptor_set;
 }
 
-void VulkanRenderer::CreatePostProcessingPipeline() {
-    post_processing_.pipeline = {
-        {"shaders/post.vert.spv", "shaders/nopost.frag.spv"}, {}, {}, VK_CULL_MODE_BACK_BIT,
-        {false, false, VK_COMPARE_OP_ALWAYS}, {}, {post_processing_.descriptor_set_layout},
-    };
-    CreatePipeline(post_processing_.pipeline);
+void VulkanRenderer::CreatePostTarget(PostTarget &target, VkExtent2D extent) {
+    const TextureHandle handle = CreateImage({extent.width, extent.height}, vk_surface_format_.format,
+                                             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                                             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    target.image = handle.image;
+    target.memory = handle.memory;
+    target.view = CreateImageView(target.image, vk_surface_format_.format, VK_IMAGE_ASPECT_COLOR_BIT);
+    target.extent = extent;
+
+    if (!dynamic_rendering_) {
+        VkFramebufferCreateInfo framebuffer_info{};
+        framebuffer_info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        framebuffer_info.renderPass = post_processing_.chain_render_pass;
+        framebuffer_info.attachmentCount = 1;
+        framebuffer_info.pAttachments = &target.view;
+        framebuffer_info.width = extent.width;
+        framebuffer_info.height = extent.height;
+        framebuffer_info.layers = 1;
+
+        if (vkCreateFramebuffer(vk_device_, &framebuffer_info, nullptr, &target.framebuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create post target framebuffer!");
+        }
+    }
+
+    target.descriptor_set = CreatePostDescriptorSet(post_processing_.descriptor_pool, target.view);
 }
 
-void VulkanRenderer::DestroyPostProcessingResources() {
-    if (post_processing_.sampler != VK_NULL_HANDLE)
-        vkDestroySampler(vk_device_, post_processing_.sampler, nullptr);
-    if (post_processing_.descriptor_pool != VK_NULL_HANDLE)
-        vkDestroyDescriptorPool(vk_device_, post_processing_.descriptor_pool, nullptr);
-    if (post_processing_.descriptor_set_layout != VK_NULL_HANDLE)
-        vkDestroyDescriptorSetLayout(vk_device_, post_processing_.descriptor_set_layout, nullptr);
-    if (post_processing_.pipeline.pipeline != VK_NULL_HANDLE)
-        vkDestroyPipeline(vk_device_, post_processing_.pipeline.pipeline, nullptr);
-    if (post_processing_.pipeline.pipeline_layout != VK_NULL_HANDLE)
-        vkDestroyPipelineLayout(vk_device_, post_processing_.pipeline.pipeline_layout, nullptr);
+void VulkanRenderer::DestroyPostTarget(PostTarget &target) const {
+    if (target.framebuffer != VK_NULL_HANDLE)
+        vkDestroyFramebuffer(vk_device_, target.framebuffer, nullptr);
+    if (target.view != VK_NULL_HANDLE)
+        vkDestroyImageView(vk_device_, target.view, nullptr);
+    if (target.image != VK_NULL_HANDLE)
+        vkDestroyImage(vk_device_, target.image, nullptr);
+    if (target.memory != VK_NULL_HANDLE)
+        FreeDeviceMemory(target.memory);
+    target = {};
+}
+
+void VulkanRenderer::CreatePostProcessingTargets() {
+    CreatePostProcessingFramebuffer();
+    post_processing_.descriptor_set = CreatePostDescriptorSet(post_processing_.descriptor_pool,
+                                                              post_processing_.color_view);
+    for (PostTarget &target: post_processing_.ping_pong)
+        CreatePostTarget(target, vk_extent_);
+
+    const VkExtent2D half = {std::max(vk_extent_.width / 2, 1u), std::max(vk_extent_.height / 2, 1u)};
+    const VkExtent2D quarter = {std::max(vk_extent_.width / 4, 1u), std::max(vk_extent_.height / 4, 1u)};
+    CreatePostTarget(post_processing_.bloom[0], half);
+    CreatePostTarget(post_processing_.bloom[1], quarter);
+    CreatePostTarget(post_processing_.bloom[2], half);
+    post_processing_.compute_graph_dirty = true;
+}
+
+void VulkanRenderer::DestroyPostProcessingTargets() {
+    for (PostTarget &target: post_processing_.ping_pong)
+        DestroyPostTarget(target);
+    for (PostTarget &target: post_processing_.bloom)
+        DestroyPostTarget(target);
+    DestroyComputePostGraph();
+
     if (post_processing_.framebuffer != VK_NULL_HANDLE)
         vkDestroyFramebuffer(vk_device_, post_processing_.framebuffer, nullptr);
-    if (post_processing_.render_pass != VK_NULL_HANDLE)
-        vkDestroyRenderPass(vk_device_, post_processing_.render_pass, nullptr);
     if (post_processing_.color_view != VK_NULL_HANDLE)
         vkDestroyImageView(vk_device_, post_processing_.color_view, nullptr);
     if (post_processing_.color_image != VK_NULL_HANDLE)
         vkDestroyImage(vk_device_, post_processing_.color_image, nullptr);
     if (post_processing_.color_memory != VK_NULL_HANDLE)
-        vkFreeMemory(vk_device_, post_processing_.color_memory, nullptr);
+        FreeDeviceMemory(post_processing_.color_memory);
     if (post_processing_.depth_view != VK_NULL_HANDLE)
         vkDestroyImageView(vk_device_, post_processing_.depth_view, nullptr);
     if (post_processing_.depth_image != VK_NULL_HANDLE)
         vkDestroyImage(vk_device_, post_processing_.depth_image, nullptr);
     if (post_processing_.depth_memory != VK_NULL_HANDLE)
-        vkFreeMemory(vk_device_, post_processing_.depth_memory, nullptr);
+        FreeDeviceMemory(post_processing_.depth_memory);
+    post_processing_.framebuffer = VK_NULL_HANDLE;
+    post_processing_.color_view = VK_NULL_HANDLE;
+    post_processing_.color_image = VK_NULL_HANDLE;
+    post_processing_.color_memory = VK_NULL_HANDLE;
+    post_processing_.depth_view = VK_NULL_HANDLE;
+    post_processing_.depth_image = VK_NULL_HANDLE;
+    post_processing_.depth_memory = VK_NULL_HANDLE;
+
+    // Every set in the pool belongs to one of the targets above.
+    if (post_processing_.descriptor_pool != VK_NULL_HANDLE)
+        vkResetDescriptorPool(vk_device_, post_processing_.descriptor_pool, 0);
+    post_processing_.descriptor_set = VK_NULL_HANDLE;
 }
 
-void VulkanRenderer::ReloadPostProcessingShader(const std::string &fragment_shader_path) {
-    // Wait for the device to be idle before destroying the pipeline
-    vkDeviceWaitIdle(vk_device_);
+void VulkanRenderer::CreatePostProcessingPipeline() {
+    const PipelineHelper layout_helper = {
+        {}, {}, {}, VK_CULL_MODE_BACK_BIT, {false, false, VK_COMPARE_OP_ALWAYS},
+        {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostPassConstants)}},
+        {post_processing_.descriptor_set_layout, post_processing_.descriptor_set_layout}
+    };
+
+    VkPipelineLayoutCreateInfo layout_info = {
+        VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO, nullptr, 0,
+        static_cast<uint32_t>(layout_helper.descriptor_set_layouts.size()), layout_helper.descriptor_set_layouts.data(),
+        static_cast<uint32_t>(layout_helper.push_constant_ranges.size()), layout_helper.push_constant_ranges.data()
+    };
+    if (vkCreatePipelineLayout(vk_device_, &layout_info, nullptr, &post_processing_.effect_layout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create post-processing pipeline layout!");
+    }
+
+    // Compute passes write set 1 and composites read the bloom result from set 2.
+    const std::array compute_set_layouts = {
+        post_processing_.descriptor_set_layout, post_processing_.storage_set_layout,
+        post_processing_.descriptor_set_layout
+    };
+    const VkPushConstantRange compute_push_range = {VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PostPassConstants)};
+    layout_info.setLayoutCount = compute_set_layouts.size();
+    layout_info.pSetLayouts = compute_set_layouts.data();
+    layout_info.pushConstantRangeCount = 1;
+    layout_info.pPushConstantRanges = &compute_push_range;
+    if (vkCreatePipelineLayout(vk_device_, &layout_info, nullptr, &post_processing_.compute_layout) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute post-processing pipeline layout!");
+    }
+
+    // Only sampling effects have a shader of their own. The pass-through ones
+    // are needed for the very first frame; the others compile in the background.
+    BuildPostEffect(GetPostHeadShader(PostEffectType::Passthrough)).build.wait();
+    BuildComputePostEffect(GetComputePostShader(GetPostHeadShader(PostEffectType::Passthrough))).build.wait();
+    for (const PostEffectType type: {PostEffectType::Pixelation, PostEffectType::ChromaticAberration,
+                                     PostEffectType::Bloom})
+        BuildPostEffect(GetPostHeadShader(type));
+    BuildPostEffect(kBloomDownShader);
+    BuildPostEffect(kBloomUpShader);
+
+    for (const PostEffectType type: {PostEffectType::Pixelation, PostEffectType::ChromaticAberration,
+                                     PostEffectType::Bloom})
+        BuildComputePostEffect(GetComputePostShader(GetPostHeadShader(type)));
+    BuildComputePostEffect(GetComputePostShader(kBloomDownShader));
+    BuildComputePostEffect(GetComputePostShader(kBloomUpShader));
+    SetPostChain({});
+}
+
+PostEffect &VulkanRenderer::BuildComputePostEffect(const std::string &compute_shader_path) {
+    PostEffect &effect = post_processing_.effects[compute_shader_path];
+    effect.pipeline = {
+        {compute_shader_path}, {}, {}, {}, {}, {}, {}, post_processing_.compute_layout
+    };
 
-    // Destroy only the existing pipeline (not the layout or other resources)
-    if (post_processing_.pipeline.pipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(vk_device_, post_processing_.pipeline.pipeline, nullptr);
+    PipelineHelper *helper = &effect.pipeline;
+    effect.build = std::async(std::launch::async, [this, helper] {
+        PROFILE_SCOPE("BuildComputePostEffect");
+        CreateComputePipeline(*helper);
+    }).share();
+    return effect;
+}
+
+void VulkanRenderer::CreateComputePipeline(PipelineHelper &pipeline_helper) {
+    VkShaderModule compute_shader = CreateShaderModule(ReadFile(pipeline_helper.shaders[0]));
+    if (compute_shader == VK_NULL_HANDLE) {
+        spdlog::error("Failed finding shaders!");
+        std::exit(EXIT_FAILURE);
     }
 
-    // Destroy existing pipeline layout if it exists
-    if (post_processing_.pipeline.pipeline_layout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(vk_device_, post_processing_.pipeline.pipeline_layout, nullptr);
+    VkComputePipelineCreateInfo pipeline_info{};
+    pipeline_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_info.stage = {
+        VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO, nullptr, 0, VK_SHADER_STAGE_COMPUTE_BIT, compute_shader,
+        "main"
+    };
+    pipeline_info.layout = pipeline_helper.pipeline_layout;
+
+    if (vkCreateComputePipelines(vk_device_, vk_pipeline_cache_, 1, &pipeline_info, nullptr,
+                                 &pipeline_helper.pipeline) != VK_SUCCESS) {
+        spdlog::error("Failed to create compute pipeline {}", pipeline_helper.shaders[0]);
+        std::exit(EXIT_FAILURE);
     }
 
-    post_processing_.pipeline = {
+    vkDestroyShaderModule(vk_device_, compute_shader, nullptr);
+}
+
+PostEffect &VulkanRenderer::BuildPostEffect(const std::string &fragment_shader_path) {
+    PostEffect &effect = post_processing_.effects[fragment_shader_path];
+    effect.pipeline = {
         {"shaders/post.vert.spv", fragment_shader_path}, {}, {}, VK_CULL_MODE_BACK_BIT,
         {false, false, VK_COMPARE_OP_ALWAYS},
-        {{VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(glm::mat4)}},
-        {post_processing_.descriptor_set_layout}
+        {{VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PostPassConstants)}},
+        {post_processing_.descriptor_set_layout, post_processing_.descriptor_set_layout}, post_processing_.effect_layout
     };
-    CreatePipeline(post_processing_.pipeline);
+
+    // Pipeline creation only reads renderer state and the pipeline cache is
+    // internally synchronized, so effects can compile concurrently. Each task
+    // writes nothing but its own PipelineHelper.
+    PipelineHelper *helper = &effect.pipeline;
+    effect.build = std::async(std::launch::async, [this, helper] {
+        PROFILE_SCOPE("BuildPostEffect");
+        CreatePipeline(*helper);
+    }).share();
+    return effect;
+}
+
+std::vector<PostPass> VulkanRenderer::BuildPostPasses(const std::vector<PostEffectStep> &chain) {
+    std::vector<PostPass> passes;
+    for (const PostEffectStep &step: chain) {
+        if (step.type == PostEffectType::Bloom) {
+            // x: threshold, y: strength, z: exposure. The bright pass runs on
+            // the first half resolution downsample, so every later pass costs a
+            // fraction of a full screen one whatever the output size.
+            PostPass prefilter{kBloomDownShader};
+            prefilter.constants.head_params = {step.params.x, 1.0f, 0.0f, 0.0f};
+            prefilter.bloom_output = 0;
+
+            PostPass downsample{kBloomDownShader};
+            downsample.constants.head_params = {step.params.x, 0.0f, 0.0f, 0.0f};
+            downsample.bloom_input = 0;
+            downsample.bloom_output = 1;
+
+            PostPass upsample{kBloomUpShader};
+            upsample.bloom_input = 1;
+            upsample.bloom_output = 2;
+
+            PostPass composite{GetPostHeadShader(step.type)};
+            composite.constants.head_params = {step.params.y, step.params.z, 0.0f, 0.0f};
+            composite.samples_bloom = true;
+
+            passes.insert(passes.end(), {prefilter, downsample, upsample, composite});
+            continue;
+        }
+
+        if (!IsPointwiseEffect(step.type)) {
+            PostPass pass{GetPostHeadShader(step.type)};
+            pass.constants.head_params = step.params;
+            passes.push_back(pass);
+            continue;
+        }
+
+        // Fuse into the previous pass instead of writing and re-reading a full image.
+        if (passes.empty() || passes.back().constants.op_count == kMaxFusedPostOps)
+            passes.push_back({GetPostHeadShader(PostEffectType::Passthrough)});
+
+        PostPassConstants &constants = passes.back().constants;
+        constants.ops[constants.op_count] = static_cast<std::int32_t>(step.type);
+        constants.op_params[constants.op_count] = step.params;
+        ++constants.op_count;
+    }
+
+    if (passes.empty())
+        passes.push_back({GetPostHeadShader(PostEffectType::Passthrough)});
+    return passes;
+}
+
+bool VulkanRenderer::SetPostChain(const std::vector<PostEffectStep> &chain) {
+    // Both flavours of every pass are resolved up front so toggling compute
+    // post-processing never has to wait for a chain switch.
+    const auto resolve = [this](const std::string &shader, VkPipeline &pipeline) {
+        const auto it = post_processing_.effects.find(shader);
+        if (it == post_processing_.effects.end()) {
+            spdlog::warn("Post effect {} was never built", shader);
+            return false;
+        }
+        if (it->second.build.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return false;
+        pipeline = it->second.pipeline.pipeline;
+        return true;
+    };
+
+    std::vector<PostPass> passes = BuildPostPasses(chain);
+    PostPass present_pass{GetPostHeadShader(PostEffectType::Passthrough)};
+    passes.push_back(present_pass);
+    for (PostPass &pass: passes) {
+        if (!resolve(pass.shader, pass.pipeline) ||
+            !resolve(GetComputePostShader(pass.shader), pass.compute_pipeline)) {
+            post_processing_.pending_chain = chain;
+            return false;
+        }
+    }
+    present_pass = passes.back();
+    passes.pop_back();
+
+    post_processing_.chain = chain;
+    post_processing_.passes = std::move(passes);
+    post_processing_.present_pass = present_pass;
+    post_processing_.pending_chain.reset();
+    post_processing_.compute_graph_dirty = true;
+    return true;
+}
+
+PostTarget VulkanRenderer::GetSwapchainTarget() const {
+    PostTarget target;
+    target.image = vk_swapchain_images_[current_image_index_];
+    target.view = vk_swapchain_image_views_[current_image_index_];
+    if (!vk_swapchain_framebuffers_.empty()) target.framebuffer = vk_swapchain_framebuffers_[current_image_index_];
+    target.extent = vk_extent_;
+    return target;
+}
+
+void VulkanRenderer::RecordPostPass(VkCommandBuffer command_buffer, const PostPass &pass, VkDescriptorSet source,
+                                    VkExtent2D source_extent, const PostTarget &target, const bool present) const {
+    const VkExtent2D extent = target.extent;
+    VkClearValue clear_value = {};
+    clear_value.color = {0.0f, 0.0f, 0.0f, 1.0f};
+
+    if (dynamic_rendering_) {
+        VkRenderingAttachmentInfo color_attachment{};
+        color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        color_attachment.imageView = target.view;
+        color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        // Chain targets are fully covered by the fullscreen triangle.
+        color_attachment.loadOp = present ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.clearValue = clear_value;
+
+        VkRenderingInfo rendering_info{};
+        rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        rendering_info.renderArea = {{0, 0}, extent};
+        rendering_info.layerCount = 1;
+        rendering_info.colorAttachmentCount = 1;
+        rendering_info.pColorAttachments = &color_attachment;
+        vkCmdBeginRendering(command_buffer, &rendering_info);
+    } else {
+        VkRenderPassBeginInfo render_pass_info{};
+        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_info.renderPass = present ? vk_render_pass_ : post_processing_.chain_render_pass;
+        render_pass_info.framebuffer = target.framebuffer;
+        render_pass_info.renderArea = {{0, 0}, extent};
+        render_pass_info.clearValueCount = 1;
+        render_pass_info.pClearValues = &clear_value;
+        vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
+    }
+
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pass.pipeline);
+    const std::array descriptor_sets = {source, post_processing_.bloom.back().descriptor_set};
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, post_processing_.effect_layout, 0,
+                            pass.samples_bloom ? 2 : 1, descriptor_sets.data(), 0, nullptr);
+
+    PostPassConstants constants = pass.constants;
+    constants.texel_size = {
+        1.0f / static_cast<float>(source_extent.width), 1.0f / static_cast<float>(source_extent.height)
+    };
+    vkCmdPushConstants(command_buffer, post_processing_.effect_layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                       sizeof(PostPassConstants), &constants);
+
+    VkViewport viewport = {0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f};
+    VkRect2D scissor = {{0, 0}, extent};
+    vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+    vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+
+    vkCmdDraw(command_buffer, 3, 1, 0, 0); // Draw fullscreen triangle
+
+    if (dynamic_rendering_) vkCmdEndRendering(command_buffer);
+    else vkCmdEndRenderPass(command_buffer);
+}
+
+void VulkanRenderer::BuildComputePostGraph() {
+    DestroyComputePostGraph();
+    RenderGraph &graph = post_processing_.compute_graph;
+
+    // The frame graph leaves the scene color ready to sample, or on the async
+    // path releases it to this queue straight from the attachment layout.
+    RenderGraphImageState scene_state = {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    std::uint32_t scene_src_family = VK_QUEUE_FAMILY_IGNORED;
+    std::uint32_t scene_dst_family = VK_QUEUE_FAMILY_IGNORED;
+    if (UsesAsyncCompute()) {
+        scene_state.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        scene_src_family = queue_families_.graphicsFamily.value();
+        scene_dst_family = queue_families_.computeFamily.value();
+    }
+    const RenderGraphResource scene = graph.ImportImage(
+        "SceneColor", post_processing_.color_image, post_processing_.color_view,
+        {vk_surface_format_.format, vk_extent_}, scene_state, scene_src_family, scene_dst_family);
+
+    const VkExtent2D half = {std::max(vk_extent_.width / 2, 1u), std::max(vk_extent_.height / 2, 1u)};
+    const VkExtent2D quarter = {std::max(vk_extent_.width / 4, 1u), std::max(vk_extent_.height / 4, 1u)};
+    const std::array bloom_extents = {half, quarter, half};
+
+    // Every pass writes a fresh transient; the graph folds them back onto as
+    // few allocations as their lifetimes allow.
+    std::array<RenderGraphResource, 3> bloom{};
+    RenderGraphResource source = scene;
+    for (std::size_t i = 0; i < post_processing_.passes.size(); ++i) {
+        const PostPass &pass = post_processing_.passes[i];
+        const bool to_bloom = pass.bloom_output >= 0;
+        const RenderGraphResource input = pass.bloom_input >= 0 ? bloom[pass.bloom_input] : source;
+        const RenderGraphResource output = graph.CreateImage(
+            to_bloom ? "Bloom" + std::to_string(pass.bloom_output) : "PostChain" + std::to_string(i),
+            {kComputePostFormat, to_bloom ? bloom_extents[pass.bloom_output] : vk_extent_});
+
+        RenderGraph::PassBuilder builder = graph.AddPass(pass.shader, RenderGraphPassType::Compute);
+        builder.Read(input, RenderGraphAccess::Sampled).Write(output, RenderGraphAccess::StorageWrite);
+        const std::optional<RenderGraphResource> bloom_input =
+            pass.samples_bloom ? std::optional(bloom.back()) : std::nullopt;
+        if (bloom_input) builder.Read(*bloom_input, RenderGraphAccess::Sampled);
+        builder.Execute([this, pass, input, output, bloom_input](VkCommandBuffer command_buffer, const RenderGraph &) {
+            const std::vector<PostTarget> &targets = post_processing_.compute_targets;
+            RecordComputePostPass(command_buffer, pass, targets[input], targets[output],
+                                  bloom_input ? targets[*bloom_input].descriptor_set : VK_NULL_HANDLE);
+        });
+
+        if (to_bloom) bloom[pass.bloom_output] = output;
+        else source = output;
+    }
+    post_processing_.compute_result = source;
+
+    // The present pass samples the result; on the async path it is handed
+    // back to the graphics queue instead.
+    if (UsesAsyncCompute()) {
+        graph.ExportImage(source, {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL},
+                          queue_families_.computeFamily.value(), queue_families_.graphicsFamily.value());
+    } else {
+        graph.ExportImage(source, {
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+                              VK_ACCESS_2_SHADER_SAMPLED_READ_BIT
+                          });
+    }
+
+    graph.Compile(vk_device_, GetGraphAllocator(), synchronization2_);
+    spdlog::info("Compute post graph: {} passes ({} culled), {} transient images in {} KiB ({} KiB unaliased)",
+                 graph.GetPassCount(), graph.GetCulledPassCount(), graph.GetTransientImageCount(),
+                 graph.GetTransientBytes() / 1024, graph.GetUnaliasedBytes() / 1024);
+
+    // A sampled and a storage set for every image the compiled graph kept.
+    const std::uint32_t image_count = static_cast<std::uint32_t>(graph.GetResourceCount());
+    const std::array<VkDescriptorPoolSize, 2> pool_sizes = {
+        {{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, image_count}, {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, image_count}}
+    };
+    VkDescriptorPoolCreateInfo pool_info{};
+    pool_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_info.poolSizeCount = pool_sizes.size();
+    pool_info.pPoolSizes = pool_sizes.data();
+    pool_info.maxSets = image_count * 2;
+
+    if (vkCreateDescriptorPool(vk_device_, &pool_info, nullptr, &post_processing_.compute_graph_pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create compute post-processing descriptor pool!");
+    }
+
+    post_processing_.compute_targets.resize(image_count);
+    for (RenderGraphResource resource = 0; resource < image_count; ++resource) {
+        PostTarget &target = post_processing_.compute_targets[resource];
+        target.extent = graph.GetDesc(resource).extent;
+        if (resource == scene) {
+            target.descriptor_set = post_processing_.descriptor_set;
+            continue;
+        }
+        if (!graph.IsUsed(resource)) continue;
+
+        target.image = graph.GetImage(resource);
+        target.view = graph.GetView(resource);
+        target.descriptor_set = CreatePostDescriptorSet(post_processing_.compute_graph_pool, target.view);
+
+        VkDescriptorSetAllocateInfo alloc_info{};
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.descriptorPool = post_processing_.compute_graph_pool;
+        alloc_info.descriptorSetCount = 1;
+        alloc_info.pSetLayouts = &post_processing_.storage_set_layout;
+
+        if (vkAllocateDescriptorSets(vk_device_, &alloc_info, &target.storage_set) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate post-processing storage set!");
+        }
+
+        VkDescriptorImageInfo image_info{};
+        image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        image_info.imageView = target.view;
+
+        VkWriteDescriptorSet descriptor_write{};
+        descriptor_write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptor_write.dstSet = target.storage_set;
+        descriptor_write.dstBinding = 0;
+        descriptor_write.dstArrayElement = 0;
+        descriptor_write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        descriptor_write.descriptorCount = 1;
+        descriptor_write.pImageInfo = &image_info;
+
+        vkUpdateDescriptorSets(vk_device_, 1, &descriptor_write, 0, nullptr);
+    }
+    post_processing_.compute_graph_dirty = false;
+}
+
+void VulkanRenderer::DestroyComputePostGraph() {
+    post_processing_.compute_graph.Destroy();
+    post_processing_.compute_targets.clear();
+    if (post_processing_.compute_graph_pool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(vk_device_, post_processing_.compute_graph_pool, nullptr);
+    post_processing_.compute_graph_pool = VK_NULL_HANDLE;
+}
+
+void VulkanRenderer::RecordComputePostPass(VkCommandBuffer command_buffer, const PostPass &pass,
+                                           const PostTarget &source, const PostTarget &target,
+                                           VkDescriptorSet bloom) const {
+    vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pass.compute_pipeline);
+    const std::array descriptor_sets = {source.descriptor_set, target.storage_set, bloom};
+    vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, post_processing_.compute_layout, 0,
+                            pass.samples_bloom ? 3 : 2, descriptor_sets.data(), 0, nullptr);
+
+    PostPassConstants constants = pass.constants;
+    constants.texel_size = {
+        1.0f / static_cast<float>(source.extent.width), 1.0f / static_cast<float>(source.extent.height)
+    };
+    vkCmdPushConstants(command_buffer, post_processing_.compute_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(PostPassConstants), &constants);
+
+    vkCmdDispatch(command_buffer, (target.extent.width + kComputePostGroupSize - 1) / kComputePostGroupSize,
+                  (target.extent.height + kComputePostGroupSize - 1) / kComputePostGroupSize, 1);
+}
+
+void VulkanRenderer::SetComputePostProcessing(const bool enabled, const bool async) {
+    post_processing_.use_compute = enabled;
+    post_processing_.async_compute = async;
+    post_processing_.compute_graph_dirty = true;
+    spdlog::info("Post-processing runs as {}", !enabled ? "fragment passes"
+                                                : UsesAsyncCompute() ? "async compute" : "compute");
+}
+
+void VulkanRenderer::UpdatePostEffects() {
+    // Called after the frame fence, so only pipelines of the active chain can
+    // still be in use; they are kept until their replacements are swapped in.
+    std::erase_if(post_processing_.retired_pipelines, [this](VkPipeline pipeline) {
+        const auto in_use = [pipeline](const PostPass &pass) {
+            return pass.pipeline == pipeline || pass.compute_pipeline == pipeline;
+        };
+        if (std::ranges::any_of(post_processing_.passes, in_use) || in_use(post_processing_.present_pass))
+            return false;
+        vkDestroyPipeline(vk_device_, pipeline, nullptr);
+        return true;
+    });
+
+    if (post_processing_.pending_chain)
+        SetPostChain(*post_processing_.pending_chain);
+    if (post_processing_.use_compute && post_processing_.compute_graph_dirty)
+        BuildComputePostGraph();
+}
+
+void VulkanRenderer::RegisterPostChains(const std::unordered_map<int, std::vector<PostEffectStep>> &chains) {
+    post_chains_ = chains;
+}
+
+void VulkanRenderer::DestroyPostProcessingResources() {
+    for (auto &effect: post_processing_.effects | std::views::values) {
+        if (effect.build.valid()) effect.build.wait();
+        if (effect.pipeline.pipeline != VK_NULL_HANDLE)
+            vkDestroyPipeline(vk_device_, effect.pipeline.pipeline, nullptr);
+    }
+    post_processing_.effects.clear();
+    post_processing_.passes.clear();
+    for (VkPipeline pipeline: post_processing_.retired_pipelines)
+        vkDestroyPipeline(vk_device_, pipeline, nullptr);
+    post_processing_.retired_pipelines.clear();
+    if (post_processing_.effect_layout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(vk_device_, post_processing_.effect_layout, nullptr);
+    if (post_processing_.compute_layout != VK_NULL_HANDLE)
+        vkDestroyPipelineLayout(vk_device_, post_processing_.compute_layout, nullptr);
+
+    DestroyPostProcessingTargets();
+
+    if (post_processing_.sampler != VK_NULL_HANDLE)
+        vkDestroySampler(vk_device_, post_processing_.sampler, nullptr);
+    if (post_processing_.descriptor_pool != VK_NULL_HANDLE)
+        vkDestroyDescriptorPool(vk_device_, post_processing_.descriptor_pool, nullptr);
+    if (post_processing_.descriptor_set_layout != VK_NULL_HANDLE)
+        vkDestroyDescriptorSetLayout(vk_device_, post_processing_.descriptor_set_layout, nullptr);
+    if (post_processing_.storage_set_layout != VK_NULL_HANDLE)
+        vkDestroyDescriptorSetLayout(vk_device_, post_processing_.storage_set_layout, nullptr);
+    if (post_processing_.chain_render_pass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(vk_device_, post_processing_.chain_render_pass, nullptr);
+    if (post_processing_.render_pass != VK_NULL_HANDLE)
+        vkDestroyRenderPass(vk_device_, post_processing_.render_pass, nullptr);
+}
+
+void VulkanRenderer::ReloadPostProcessingShader(const std::string &fragment_shader_path) {
+    const auto it = post_processing_.effects.find(fragment_shader_path);
+    if (it != post_processing_.effects.end()) {
+        // The old pipeline may still be recorded in the frame in flight.
+        it->second.build.wait();
+        if (it->second.pipeline.pipeline != VK_NULL_HANDLE)
+            post_processing_.retired_pipelines.push_back(it->second.pipeline.pipeline);
+    }
+
+    if (fragment_shader_path.ends_with(".comp.spv"))
+        BuildComputePostEffect(fragment_shader_path);
+    else
+        BuildPostEffect(fragment_shader_path);
+    SetPostChain(post_processing_.chain);
 }
 
 void VulkanRenderer::HandleShaderSwitch(int key) {
-    if (const auto shader = shaders_.find(key); shader == shaders_.end())
+    if (const auto chain = post_chains_.find(key); chain == post_chains_.end())
         spdlog::warn("Unhandled key press in shader switch: {}", key);
     else
-        ReloadPostProcessingShader(shader->second);
+        SetPostChain(chain->second);
+}
+
+void VulkanRenderer::CreateTimestampQueries() {
+    QueueFamilyIndices indices = FindQueueFamilies(vk_physical_device_);
+
+    std::uint32_t family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device_, &family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> families(family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(vk_physical_device_, &family_count, families.data());
+
+    const std::uint32_t valid_bits = families[indices.graphicsFamily.value()].timestampValidBits;
+    if (valid_bits == 0) {
+        spdlog::warn("Graphics queue does not support timestamps, GPU timings disabled");
+        return;
+    }
+
+    VkPhysicalDeviceProperties properties = {};
+    vkGetPhysicalDeviceProperties(vk_physical_device_, &properties);
+
+    gpu_timestamps_.ns_per_tick = properties.limits.timestampPeriod;
+    gpu_timestamps_.valid_mask = valid_bits >= 64 ? ~0ull : (1ull << valid_bits) - 1;
+
+    VkQueryPoolCreateInfo pool_info = {};
+    pool_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    pool_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    pool_info.queryCount = GpuTimestamps::kQueriesPerFrame * GpuTimestamps::kFrames;
+
+    if (vkCreateQueryPool(vk_device_, &pool_info, nullptr, &gpu_timestamps_.query_pool) != VK_SUCCESS) {
+        spdlog::warn("Failed to create timestamp query pool, GPU timings disabled");
+        gpu_timestamps_.query_pool = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanRenderer::DestroyTimestampQueries() {
+    if (gpu_timestamps_.query_pool != VK_NULL_HANDLE && vk_device_ != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(vk_device_, gpu_timestamps_.query_pool, nullptr);
+        gpu_timestamps_.query_pool = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanRenderer::WriteTimestamp(GpuScope scope, bool end, VkCommandBuffer command_buffer) const {
+    if (gpu_timestamps_.query_pool == VK_NULL_HANDLE) return;
+
+    const std::uint32_t slot = gpu_timestamps_.frame % GpuTimestamps::kFrames;
+    const std::uint32_t query = slot * GpuTimestamps::kQueriesPerFrame + static_cast<std::uint32_t>(scope) * 2 +
+                                (end ? 1 : 0);
+    vkCmdWriteTimestamp(command_buffer != VK_NULL_HANDLE ? command_buffer : vk_command_buffer_,
+                        end ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                        gpu_timestamps_.query_pool, query);
+}
+
+void VulkanRenderer::CollectTimestamps() {
+    if (gpu_timestamps_.query_pool == VK_NULL_HANDLE) return;
+
+    const std::uint32_t slot = gpu_timestamps_.frame % GpuTimestamps::kFrames;
+    if (!gpu_timestamps_.written[slot]) return;
+    gpu_timestamps_.written[slot] = false;
+
+    // Value/availability pairs; never wait, a slot that is not ready yet is
+    // simply dropped from the history.
+    std::array<std::uint64_t, GpuTimestamps::kQueriesPerFrame * 2> results = {};
+    vkGetQueryPoolResults(vk_device_, gpu_timestamps_.query_pool, slot * GpuTimestamps::kQueriesPerFrame,
+                          GpuTimestamps::kQueriesPerFrame, sizeof(results), results.data(),
+                          sizeof(std::uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    for (std::uint32_t query = 0; query < GpuTimestamps::kQueriesPerFrame; ++query)
+        if (results[query * 2 + 1] == 0) return;
+
+    for (std::uint32_t scope = 0; scope < GpuTimestamps::kScopes; ++scope) {
+        const std::uint64_t begin = results[scope * 4 + 0];
+        const std::uint64_t end = results[scope * 4 + 2];
+        const std::uint64_t ticks = (end - begin) & gpu_timestamps_.valid_mask;
+        const double ms = static_cast<double>(ticks) * gpu_timestamps_.ns_per_tick / 1.0e6;
+        gpu_timestamps_.last_ms[scope] = ms;
+        gpu_timestamps_.history[scope][gpu_timestamps_.history_head] = ms;
+    }
+
+    gpu_timestamps_.history_head = (gpu_timestamps_.history_head + 1) % GpuTimestamps::kHistory;
+    gpu_timestamps_.history_count = std::min(gpu_timestamps_.history_count + 1, GpuTimestamps::kHistory);
+}
+
+std::vector<GpuScopeTiming> VulkanRenderer::GetGpuTimings() const {
+    static constexpr std::array<const char *, GpuTimestamps::kScopes> names = {
+        "ScenePass", "Skybox", "Opaque", "PostPass", "Shadows", "DepthPrepass"
+    };
+
+    std::vector<GpuScopeTiming> timings;
+    if (gpu_timestamps_.history_count == 0) return timings;
+
+    timings.reserve(GpuTimestamps::kScopes);
+    for (std::uint32_t scope = 0; scope < GpuTimestamps::kScopes; ++scope) {
+        double total = 0.0;
+        double max = 0.0;
+        for (std::uint32_t i = 0; i < gpu_timestamps_.history_count; ++i) {
+            total += gpu_timestamps_.history[scope][i];
+            max = std::max(max, gpu_timestamps_.history[scope][i]);
+        }
+        timings.push_back({
+            names[scope], gpu_timestamps_.last_ms[scope], total / gpu_timestamps_.history_count, max
+        });
+    }
+    return timings;
 }
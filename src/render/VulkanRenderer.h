@@ -7,12 +7,22 @@
 #include <BufferHandle.h>
 #include <GlobalLight.h>
 #include <TextureHandle.h>
+#include <ThreadPool.h>
 #include <Vertex.h>
+#include <render/DrawList.h>
+#include <render/LightClusters.h>
+#include <render/RenderGraph.h>
+#include <render/ShadowMaps.h>
 #include <render/Renderer.h>
 #include <window/Window.h>
 
+#include <future>
+#include <memory>
+#include <span>
+
 struct Mesh;
 struct oVertex;
+struct oCompactVertex;
 struct Material_UBO;
 class ObjectComponent;
 const std::vector validationLayers = {
@@ -23,6 +33,31 @@ const std::vector deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+// Offscreen targets standing in for swapchain images in headless mode.
+constexpr std::uint32_t kHeadlessImageCount = 1;
+constexpr VkFormat kHeadlessColorFormat = VK_FORMAT_R8G8B8A8_SRGB;
+
+// Storage images of the compute post path. sRGB formats cannot be written
+// as storage, so intermediate results are kept linear in half floats.
+constexpr VkFormat kComputePostFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr std::uint32_t kComputePostGroupSize = 8; // GROUP_SIZE in post_compute.glsl
+
+// Scene recording threads, including the one calling EndFrame. Each takes at
+// least this many draws, so small scenes stay on a single thread.
+constexpr std::size_t kMaxRecordingThreads = 8;
+constexpr std::size_t kMinDrawsPerRecordingSlot = 128;
+
+// Size of the bindless texture table, lowered to what the device allows.
+// The texture index is pushed right after the model and normal matrices.
+constexpr std::uint32_t kMaxBindlessTextures = 16384;
+// What the main pass's fragment stage uses besides the table: the
+// transformation and material blocks, three light buffers, the shadow
+// block, the two shadow maps and the color attachment. The table's limits
+// count them too.
+constexpr std::uint32_t kMainFragmentResources = 9;
+constexpr std::uint32_t kMainFragmentSamplers = 2;
+constexpr std::uint32_t kTextureIndexPushOffset = sizeof(DrawTransform);
+
 #ifdef NDEBUG
 constexpr bool enableValidationLayers = false;
 #else
@@ -32,6 +67,8 @@ constexpr bool enableValidationLayers = true;
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    /// Compute-only family, used to run post-processing asynchronously.
+    std::optional<uint32_t> computeFamily;
 
     [[nodiscard]] bool isComplete() const {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -62,9 +99,96 @@ struct PipelineHelper {
     DepthHelper depth_helper{};
     std::vector<VkPushConstantRange> push_constant_ranges{};
     std::vector<VkDescriptorSetLayout> descriptor_set_layouts{};
-    VkPipelineLayout pipeline_layout;
-    VkPipeline pipeline;
+    /// Left null, CreatePipeline makes a layout; set, the layout is shared and reused.
+    VkPipelineLayout pipeline_layout{};
+    VkPipeline pipeline{};
     VkPipelineColorBlendAttachmentState *color_blend_attachment = nullptr;
+    /// Render pass the pipeline is made for; null means the swapchain pass.
+    VkRenderPass render_pass{};
+    /// Depth attachment format under dynamic rendering; undefined means color only.
+    VkFormat depth_format = VK_FORMAT_UNDEFINED;
+    /// Constant and slope depth bias, for shadow maps; zero leaves it off.
+    glm::vec2 depth_bias{0.0f};
+    /// Color targets of the pass; a pipeline without a fragment shader leaves them untouched.
+    std::uint32_t color_attachment_count = 1;
+};
+
+// Float is oVertex as loaded. Compact is oCompactVertex: quantized positions
+// decoded through the model matrix, octahedral normals and half-float UVs.
+enum class VertexFormat : std::uint8_t {
+    Float,
+    Compact
+};
+
+// A post-processing fragment shader. Effects are compiled on worker threads
+// when registered; until `build` is ready the pipeline must not be touched.
+struct PostEffect {
+    PipelineHelper pipeline;
+    std::shared_future<void> build;
+};
+
+// Pointwise effects only transform the color of their own pixel, so any
+// number of them (up to kMaxFusedPostOps) fuse into the pass before them.
+// Sampling effects read the input around the pixel and always start a pass.
+// Pointwise values match the OP_* defines in post_common.glsl.
+enum class PostEffectType : std::int32_t {
+    Grayscale = 0,
+    ColorReduction,
+    Scanlines,
+    Vignette,
+    Brightness,
+    Passthrough,
+    Pixelation,
+    ChromaticAberration,
+    Bloom
+};
+
+constexpr int kMaxFusedPostOps = 4;
+
+struct PostEffectStep {
+    PostEffectType type;
+    /// Effect parameters; see the shader of each effect for their meaning.
+    glm::vec4 params{0.0f};
+};
+
+// Push constants of every post pass, laid out as PostParams in post_common.glsl.
+struct PostPassConstants {
+    glm::vec4 head_params{0.0f};
+    glm::ivec4 ops{-1};
+    glm::vec4 op_params[kMaxFusedPostOps]{};
+    glm::vec2 texel_size{0.0f};
+    std::int32_t op_count = 0;
+    std::int32_t padding = 0;
+};
+
+static_assert(sizeof(PostPassConstants) <= 128, "Post push constants must fit the guaranteed 128 bytes");
+
+// One full-screen draw of a chain: a sampling head plus the ops fused into it.
+// Bloom expands into passes over its own pyramid; those read and write
+// PostProcessing::bloom targets instead of the chain images.
+struct PostPass {
+    std::string shader;
+    VkPipeline pipeline{};
+    VkPipeline compute_pipeline{};
+    PostPassConstants constants{};
+    /// Bloom target sampled instead of the chain input, or -1.
+    std::int32_t bloom_input = -1;
+    /// Bloom target rendered to instead of the next chain image, or -1.
+    std::int32_t bloom_output = -1;
+    /// Binds the last bloom target as set 1 for the composite.
+    bool samples_bloom = false;
+};
+
+// Intermediate image a post pass renders into and the next one samples.
+struct PostTarget {
+    VkImage image{};
+    VkDeviceMemory memory{};
+    VkImageView view{};
+    VkFramebuffer framebuffer{};
+    VkDescriptorSet descriptor_set{};
+    /// Storage image binding for compute targets.
+    VkDescriptorSet storage_set{};
+    VkExtent2D extent{};
 };
 
 struct Skybox {
@@ -76,16 +200,18 @@ struct Skybox {
     VkDescriptorSetLayout descriptor_set_layout{};
     PipelineHelper pipeline;
     VkDescriptorPool descriptor_pool{};
-    BufferHandle vertex_buffer{};
-    BufferHandle index_buffer{};
-
-    static VkVertexInputBindingDescription GetBindingDescription() {
-        return VkVertexInputBindingDescription{0, sizeof(glm::vec3), VK_VERTEX_INPUT_RATE_VERTEX};
-    }
+};
 
-    static std::vector<VkVertexInputAttributeDescription> GetAttributeDescriptions() {
-        return {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0}}; // position only
-    }
+// Layered depth image the shadow passes render into one layer at a time.
+struct ShadowMap {
+    VkImage image{};
+    VkDeviceMemory memory{};
+    /// Every layer, for sampling.
+    VkImageView view{};
+    std::vector<VkImageView> layer_views;
+    /// One per layer, when rendering through a VkRenderPass.
+    std::vector<VkFramebuffer> framebuffers;
+    VkExtent2D extent{};
 };
 
 struct PostProcessing {
@@ -97,16 +223,138 @@ struct PostProcessing {
     VkImage depth_image;
     VkDeviceMemory depth_memory;
     VkImageView depth_view;
-    PipelineHelper pipeline;
     VkDescriptorSetLayout descriptor_set_layout;
     VkDescriptorPool descriptor_pool;
     VkDescriptorSet descriptor_set;
     VkSampler sampler;
+    /// Color-only pass for intermediate targets; leaves them ready to sample.
+    VkRenderPass chain_render_pass;
+    /// Passes of the active chain alternate between these two targets.
+    std::array<PostTarget, 2> ping_pong;
+    /// Bloom pyramid: half and quarter resolution downsamples, then the half
+    /// resolution upsample the composite reads.
+    std::array<PostTarget, 3> bloom;
+    /// Runs the chain as compute dispatches over storage images instead.
+    bool use_compute;
+    /// Dispatches the compute chain on the compute-only queue when there is one.
+    bool async_compute;
+    VkDescriptorSetLayout storage_set_layout;
+    VkPipelineLayout compute_layout;
+    /// The compute chain as a render graph: one transient per pass output,
+    /// aliased and synchronized by the graph. Rebuilt when the chain changes.
+    RenderGraph compute_graph;
+    bool compute_graph_dirty;
+    VkDescriptorPool compute_graph_pool;
+    /// Sets and extents of the graph images, indexed by graph resource.
+    std::vector<PostTarget> compute_targets;
+    RenderGraphResource compute_result;
+    /// Copies the result of the compute chain to the swapchain.
+    PostPass present_pass;
+    /// Every effect uses this layout, keyed by fragment shader path below.
+    VkPipelineLayout effect_layout;
+    std::unordered_map<std::string, PostEffect> effects;
+    std::vector<PostEffectStep> chain;
+    std::vector<PostPass> passes;
+    /// Chain requested while some of its effects still compile; switched to once they are ready.
+    std::optional<std::vector<PostEffectStep>> pending_chain;
+    /// Replaced pipelines, destroyed once the frame that last used them is done.
+    std::vector<VkPipeline> retired_pipelines;
+};
+
+enum class GpuScope : std::uint32_t {
+    ScenePass = 0,
+    Skybox,
+    Opaque,
+    PostPass,
+    Shadows,
+    DepthPrepass,
+    Count
+};
+
+struct GpuScopeTiming {
+    const char *name;
+    double last_ms;
+    double avg_ms;
+    double max_ms;
+};
+
+// Timestamp pairs for every GpuScope, one set per frame slot. A slot is only
+// read back when it is about to be reused, by which point the fence for the
+// frame that wrote it has been waited on, so readback never stalls the GPU.
+struct GpuTimestamps {
+    static constexpr std::uint32_t kFrames = 2;
+    static constexpr std::uint32_t kScopes = static_cast<std::uint32_t>(GpuScope::Count);
+    static constexpr std::uint32_t kQueriesPerFrame = kScopes * 2;
+    static constexpr std::uint32_t kHistory = 128;
+
+    VkQueryPool query_pool = VK_NULL_HANDLE;
+    double ns_per_tick = 0.0;
+    std::uint64_t valid_mask = 0;
+    std::uint32_t frame = 0;
+    std::array<bool, kFrames> written{};
+    std::array<std::array<double, kHistory>, kScopes> history{};
+    std::array<double, kScopes> last_ms{};
+    std::uint32_t history_head = 0;
+    std::uint32_t history_count = 0;
+};
+
+// Scene draws recorded in the last frame; the fullscreen post pass is not counted.
+struct RenderStats {
+    std::uint32_t draw_calls = 0;
+    std::uint64_t triangles = 0;
+    BindCounts binds;
+    /// Shadow map layers re-rendered, and their draws; zero while the cache holds.
+    std::uint32_t shadow_views = 0;
+    std::uint32_t shadow_draw_calls = 0;
+    /// Depth pre-pass draws, not counted in draw_calls.
+    std::uint32_t prepass_draw_calls = 0;
+};
+
+// Command pool and secondary command buffer one thread records scene draws
+// into. Slot 0 belongs to the thread calling EndFrame, the rest to workers.
+struct RecordingSlot {
+    VkCommandPool command_pool = VK_NULL_HANDLE;
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    RenderStats stats;
+};
+
+// Host-visible storage buffer that grows to fit, mapped for its whole life.
+struct StorageBuffer {
+    BufferHandle handle;
+    void *data = nullptr;
+    VkDeviceSize capacity = 0;
+};
+
+// Device memory allocated through the renderer.
+struct MemoryStats {
+    std::uint64_t allocated_bytes = 0;
+    std::uint64_t peak_bytes = 0;
+    std::uint32_t allocation_count = 0;
+};
+
+// Prefixed to the driver's pipeline cache blob on disk. The driver validates
+// its own header too, but some drivers misbehave on foreign data, so a cache
+// from another device or driver version is dropped up front.
+struct PipelineCacheFileHeader {
+    static constexpr std::uint32_t kMagic = 0x434C504D; // "MPLC"
+    static constexpr std::uint32_t kVersion = 1;
+
+    std::uint32_t magic = kMagic;
+    std::uint32_t version = kVersion;
+    std::uint32_t vendor_id = 0;
+    std::uint32_t device_id = 0;
+    std::uint32_t driver_version = 0;
+    std::uint8_t pipeline_cache_uuid[VK_UUID_SIZE] = {};
+    std::uint64_t data_size = 0;
 };
 
 class VulkanRenderer : public Renderer {
 public:
     explicit VulkanRenderer(Window *window);
+    /// Headless renderer: no GLFW window, surface or swapchain. Frames go to
+    /// offscreen images that can be read back with ReadbackFrame. Works with
+    /// software ICDs such as lavapipe (select it with VK_DRIVER_FILES).
+    VulkanRenderer(std::uint32_t width, std::uint32_t height);
     ~VulkanRenderer() override;
 
     VulkanRenderer(const VulkanRenderer &) = delete; /// Copy constructor
@@ -118,30 +366,73 @@ public:
     void OnDestroy() override;
     void Render() override;
 
+    /// Queues one draw packet per mesh. The packets are sorted by state and
+    /// recorded in EndFrame, spread over the recording threads.
     void RenderModel(BufferHandle vertex_buffer, BufferHandle index_buffer, const std::vector<Mesh> &meshes,
-                     std::vector<TextureHandle> &textures, std::vector<Material_UBO> material_ubos,
-                     const glm::mat4 &modelMatrix);
+                     const std::vector<TextureHandle> &textures, const std::vector<Material_UBO> &material_ubos,
+                     const glm::mat4 &modelMatrix, const PositionDecode &position_decode = {});
 
     bool BeginFrame();
     void EndFrame();
 
     BufferHandle CreateIndexBuffer(std::vector<uint32_t> indices);
     BufferHandle CreateVertexBuffer(std::vector<oVertex> vertices);
+    BufferHandle CreateVertexBuffer(const std::vector<oCompactVertex> &vertices);
     BufferHandle CreateVertexBuffer(const std::vector<glm::vec3> &vertices);
     TextureHandle CreateTexture(const char *path);
     void SetViewProjection(glm::mat4 matrix, glm::mat4 projection, glm::vec3 cameraPos);
 
     void DestroyTexture(TextureHandle &handle);
-    void DestroyBuffer(BufferHandle buffer_handle) const;
-    void SetLightsUBO(GlobalLighting *global_lighting);
+    void DestroyBuffer(BufferHandle buffer_handle);
+    /// Copies the scene lights; they are assigned to clusters when the frame ends.
+    void SetLights(const GlobalLighting *global_lighting);
+    /// Cached shadow maps are re-rendered when this changes, so it must change
+    /// whenever a shadow caster is added, moved or removed.
+    void SetShadowCasterRevision(std::uint64_t revision) { shadow_caster_revision_ = revision; }
 
     glm::ivec2 GetWindowSize() {
+        if (headless_) return {vk_extent_.width, vk_extent_.height};
         return window->GetFrameBufferSize();
     }
 
+    [[nodiscard]] bool IsHeadless() const { return headless_; }
+    /// Copies the last rendered headless frame to a binary PPM image.
+    bool ReadbackFrame(const std::filesystem::path &path);
+
+    [[nodiscard]] std::vector<GpuScopeTiming> GetGpuTimings() const;
+    [[nodiscard]] const RenderStats &GetRenderStats() const { return render_stats_; }
+    [[nodiscard]] const MemoryStats &GetMemoryStats() const { return memory_stats_; }
+
+    /// Maps keys to post effect chains, applied in order to the scene image.
+    void RegisterPostChains(const std::unordered_map<int, std::vector<PostEffectStep>> &chains);
+    /// Splits a chain into passes, fusing pointwise effects into the pass before them.
+    [[nodiscard]] static std::vector<PostPass> BuildPostPasses(const std::vector<PostEffectStep> &chain);
+    /// Recompiles one effect from disk in the background and swaps it in.
     void ReloadPostProcessingShader(const std::string &fragment_shader_path);
     void HandleShaderSwitch(int key);
-    std::unordered_map<int, std::string> shaders_ = {};
+    /// Switches post-processing between fragment passes and compute dispatches.
+    /// With async set, dispatches go to the compute-only queue where there is one.
+    void SetComputePostProcessing(bool enabled, bool async = true);
+    [[nodiscard]] bool IsComputePostProcessing() const { return post_processing_.use_compute; }
+    [[nodiscard]] bool UsesAsyncCompute() const {
+        return post_processing_.use_compute && post_processing_.async_compute && vk_compute_queue_ != VK_NULL_HANDLE;
+    }
+    [[nodiscard]] bool UsesDynamicRendering() const { return dynamic_rendering_; }
+    [[nodiscard]] bool UsesSynchronization2() const { return synchronization2_; }
+    [[nodiscard]] bool UsesBindlessTextures() const { return bindless_textures_; }
+    /// Lays down scene depth before the color pass, which then shades each pixel once.
+    void SetDepthPrepass(bool enabled) { depth_prepass_ = enabled; }
+    [[nodiscard]] bool UsesDepthPrepass() const { return depth_prepass_; }
+    /// Vertex layout the scene pipelines read. Must be set before any model
+    /// is loaded: buffers already uploaded keep the layout they were built with.
+    void SetVertexFormat(VertexFormat format);
+    [[nodiscard]] VertexFormat GetVertexFormat() const { return vertex_format_; }
+    /// Threads recording scene draws, the one calling EndFrame included.
+    [[nodiscard]] std::size_t GetRecordingThreadCount() const { return recording_slots_.size(); }
+    [[nodiscard]] std::size_t GetLightCount() const { return lights_.size(); }
+    /// Light references over all clusters in the last frame; total lighting work scales with it.
+    [[nodiscard]] std::size_t GetClusterLightIndexCount() const { return light_clusters_.GetIndices().size(); }
+    std::unordered_map<int, std::vector<PostEffectStep>> post_chains_ = {};
     std::array<const char*, 6> cubemap_;
     void CreateSkyboxResources();
 private:
@@ -157,6 +448,13 @@ private:
     [[nodiscard]] VkShaderModule CreateShaderModule(const std::vector<std::uint8_t> &buffer) const;
     void CreateGraphicsPipeline();
     void CreatePipeline(PipelineHelper &pipeline_helper);
+    /// Pre-pass and depth-equal pipelines, derived from the main one.
+    void CreateMainPipelineVariants();
+    void SetSceneVertexInput(PipelineHelper &pipeline_helper) const;
+    BufferHandle UploadVertexBuffer(const void *vertices, VkDeviceSize buffer_size);
+    void CreatePipelineCache();
+    void SavePipelineCache() const;
+    [[nodiscard]] PipelineCacheFileHeader GetPipelineCacheHeader() const;
     [[nodiscard]] VkViewport GetViewport() const;
     [[nodiscard]] VkRect2D GetScissor() const;
     void CreateRenderPass();
@@ -165,16 +463,16 @@ private:
     void CreateCommandBuffer();
     void BeginCommands();
     void BeginCommands() const;
-    void EndCommands() const;
+    /// Records the frame graphs and closes the frame's command buffers.
+    void EndCommands();
     void CreateSignals();
     [[nodiscard]] std::uint32_t FindMemoryType(std::uint32_t memory_type_bits, VkMemoryPropertyFlags properties) const;
     BufferHandle CreateBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
-    void RenderBuffer(BufferHandle buffer_handle, std::uint32_t vertex_count);
-    void RenderIndexedBuffer(BufferHandle vertex_buffer_handle, BufferHandle index_buffer_handle,
-                             std::uint32_t index_count, std::int32_t index_offset);
+    VkResult AllocateDeviceMemory(const VkMemoryAllocateInfo *allocate_info, VkDeviceMemory *memory);
+    void FreeDeviceMemory(VkDeviceMemory memory) const;
 
-    void SetModelMatrix(const glm::mat4 &matrix) const;
-    void SetUbo(Material_UBO &material_ubos) const;
+    void SetModelTransform(VkCommandBuffer command_buffer, const DrawTransform &transform) const;
+    void SetUbo(const Material_UBO &material_ubos) const;
     VkCommandBuffer BeginTransientCommandBuffer();
     void EndTransientCommandBuffer(VkCommandBuffer command_buffer);
     void CreateUniformBuffers();
@@ -182,8 +480,6 @@ private:
     void CreateDescriptorPools();
     void CreateDescriptorSets();
     void CreateTextureSampler();
-    void CreateDepthResources();
-    void SetTexture(TextureHandle &handle);
     void TransitionImageLayout(VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout);
     void CopyBufferToImage(VkBuffer buffer, VkImage image, glm::vec2 image_size);
     TextureHandle CreateImage(glm::vec2 image_size, VkFormat image_format, VkBufferUsageFlags usage_flags,
@@ -200,7 +496,8 @@ private:
     QueueFamilyIndices FindQueueFamilies(VkPhysicalDevice device) const;
     SwapchainSupportCapabilities FindSwapChainSupport(VkPhysicalDevice device) const;
     static std::vector<VkExtensionProperties> GetDeviceAvailableExtensions(VkPhysicalDevice device);
-    static bool AreAllDeviceExtensionsSupported(VkPhysicalDevice device);
+    [[nodiscard]] std::vector<const char *> GetRequiredDeviceExtensions() const;
+    [[nodiscard]] bool AreAllDeviceExtensionsSupported(VkPhysicalDevice device) const;
     bool IsDeviceSuitable(VkPhysicalDevice device) const;
     static bool AreAllExtensionsSupported(const std::vector<const char *> &extensions);
     [[nodiscard]] std::vector<const char *> GetRequiredInstanceExtensions() const;
@@ -210,14 +507,28 @@ private:
     void SetGlobalLights(GlobalLighting *global);
 
     bool validation_ = false;
+    bool headless_ = false;
+    // Vulkan 1.3 features, when the device has them. Without dynamic
+    // rendering every pass goes through a VkRenderPass and VkFramebuffer;
+    // without synchronization2 barriers fall back to vkCmdPipelineBarrier.
+    bool dynamic_rendering_ = false;
+    bool synchronization2_ = false;
+    RenderStats render_stats_;
+    // Freeing happens from const teardown paths, hence mutable.
+    mutable MemoryStats memory_stats_;
+    mutable std::unordered_map<VkDeviceMemory, VkDeviceSize> allocation_sizes_;
 
     VkInstance vk_instance_ = VK_NULL_HANDLE;
     VkDebugUtilsMessengerEXT vk_debug_messenger_ = VK_NULL_HANDLE;
 
     VkPhysicalDevice vk_physical_device_ = VK_NULL_HANDLE;
     VkDevice vk_device_ = VK_NULL_HANDLE;
+    VkPipelineCache vk_pipeline_cache_ = VK_NULL_HANDLE;
+    std::filesystem::path pipeline_cache_path_ = "MixedEnginePipelineCache.bin";
     VkQueue vk_graphics_queue_ = VK_NULL_HANDLE;
     VkQueue vk_present_queue_ = VK_NULL_HANDLE;
+    VkQueue vk_compute_queue_ = VK_NULL_HANDLE;
+    QueueFamilyIndices queue_families_{};
 
     VkSurfaceKHR vk_surface_ = VK_NULL_HANDLE;
     VkSwapchainKHR vk_swapchain_ = VK_NULL_HANDLE;
@@ -227,8 +538,18 @@ private:
     std::vector<VkImage> vk_swapchain_images_;
     std::vector<VkImageView> vk_swapchain_image_views_;
     std::vector<VkFramebuffer> vk_swapchain_framebuffers_;
+    std::vector<VkDeviceMemory> vk_offscreen_memory_;
+
+    void CreateOffscreenTargets();
 
     PipelineHelper main_pipeline_helper_;
+    // Depth pre-pass: basic.vert alone, sharing the main layout. With the
+    // pre-pass on, opaques draw with main_equal_pipeline_ instead, which only
+    // passes the depth the pre-pass wrote.
+    PipelineHelper depth_prepass_pipeline_helper_;
+    VkPipeline main_equal_pipeline_ = VK_NULL_HANDLE;
+    bool depth_prepass_ = false;
+    VertexFormat vertex_format_ = VertexFormat::Float;
 
     VkRenderPass vk_render_pass_ = VK_NULL_HANDLE;
 
@@ -239,6 +560,44 @@ private:
     VkSemaphore vk_render_finished_signal_ = VK_NULL_HANDLE;
     VkFence vk_still_rendering_fence_ = VK_NULL_HANDLE;
 
+    // Async compute post-processing: the scene is submitted on its own, the
+    // chain runs on the compute queue and the present pass comes last.
+    VkCommandPool vk_compute_command_pool_ = VK_NULL_HANDLE;
+    VkCommandBuffer vk_compute_command_buffer_ = VK_NULL_HANDLE;
+    VkCommandBuffer vk_present_command_buffer_ = VK_NULL_HANDLE;
+    VkSemaphore vk_scene_finished_signal_ = VK_NULL_HANDLE;
+    VkSemaphore vk_post_finished_signal_ = VK_NULL_HANDLE;
+
+    // Rebuilt every frame from imported images only, so building one costs no
+    // GPU objects. The present graph holds the present pass on the async path.
+    RenderGraph frame_graph_;
+    RenderGraph present_graph_;
+
+    /// Declares the scene pass, the post chain and the present pass.
+    void BuildFrameGraph();
+    [[nodiscard]] RenderGraphAllocator GetGraphAllocator();
+
+    void CreateAsyncComputeResources();
+    void DestroyAsyncComputeResources();
+
+    // Scene draws are queued by RenderModel and recorded into one secondary
+    // command buffer per slot when the frame ends.
+    DrawList draw_list_;
+    std::vector<RecordingSlot> recording_slots_;
+    std::unique_ptr<ThreadPool> recording_pool_;
+    // Recorded last, after every slot, so the skybox only fills what the
+    // opaques left uncovered. Allocated from slot 0's pool.
+    VkCommandBuffer skybox_command_buffer_ = VK_NULL_HANDLE;
+
+    void CreateRecordingResources();
+    void DestroyRecordingResources();
+    void RecordScenePass();
+    void BeginSceneSecondary(VkCommandBuffer command_buffer) const;
+    void RecordSceneDraws(VkCommandBuffer command_buffer, std::span<const DrawPacket> packets,
+                          RenderStats &stats) const;
+    void RecordDepthPrepass(VkCommandBuffer command_buffer, std::span<const DrawPacket> packets,
+                            RenderStats &stats) const;
+
     std::uint32_t current_image_index_ = 0;
 
     VkDescriptorSetLayout vk_uniform_set_layout_ = VK_NULL_HANDLE;
@@ -250,7 +609,18 @@ private:
     VkDescriptorSetLayout vk_texture_set_layout_ = VK_NULL_HANDLE;
     VkDescriptorPool vk_texture_pool_ = VK_NULL_HANDLE;
     VkSampler vk_texture_sampler_ = VK_NULL_HANDLE;
-    TextureHandle depth_texture_;
+
+    // Descriptor-indexing path: a single table holds every texture and draws
+    // pick theirs by index, instead of binding a set per texture.
+    bool bindless_textures_ = false;
+    std::uint32_t bindless_capacity_ = 0;
+    VkDescriptorSetLayout vk_bindless_set_layout_ = VK_NULL_HANDLE;
+    VkDescriptorPool vk_bindless_pool_ = VK_NULL_HANDLE;
+    VkDescriptorSet vk_bindless_set_ = VK_NULL_HANDLE;
+    std::vector<std::uint32_t> free_texture_indices_;
+    std::uint32_t next_texture_index_ = 0;
+
+    std::uint32_t AllocateTextureIndex();
 
     VkDescriptorSetLayout vk_uniform_bp_set_layout_ = VK_NULL_HANDLE;
     VkDescriptorSet vk_bp_set_ = VK_NULL_HANDLE;
@@ -263,29 +633,98 @@ private:
         Vertex{glm::vec3{-0.5f, 0.5f, 0.0f}, glm::vec3{0.0f, 0.0f, 1.0f}}
     };
 
+    // Set 3: every light, the cluster grid and the per-cluster light lists.
     VkDescriptorSetLayout vk_lights_set_layout_ = VK_NULL_HANDLE;
     VkDescriptorSet vk_lights_set_ = VK_NULL_HANDLE;
-    BufferHandle g_light_handle_;
-    void *global_lights_buffer_location_ = nullptr;
+    StorageBuffer light_buffer_;
+    StorageBuffer cluster_buffer_;
+    StorageBuffer light_index_buffer_;
+    std::vector<LightUBO> lights_;
+    LightClusters light_clusters_;
+    glm::mat4 view_matrix_{1.0f};
+    glm::mat4 projection_matrix_{1.0f};
+
+    /// Grows the buffer to at least size bytes and points the lights set
+    /// binding at it. Returns the mapped memory.
+    void *ReserveStorage(StorageBuffer &storage, std::uint32_t binding, VkDeviceSize size);
+    void DestroyStorage(StorageBuffer &storage);
+    void UpdateLightClusters();
+
+    // Shadow maps, also read through set 3.
+    ShadowMap cascade_shadow_map_;
+    ShadowMap point_shadow_map_;
+    ShadowCache shadow_cache_;
+    std::vector<LightUBO> shadowed_lights_;
+    DirectionalLight sun_;
+    std::uint64_t shadow_caster_revision_ = 0;
+    VkFormat shadow_format_ = VK_FORMAT_UNDEFINED;
+    VkRenderPass shadow_render_pass_ = VK_NULL_HANDLE;
+    VkSampler shadow_sampler_ = VK_NULL_HANDLE;
+    PipelineHelper shadow_pipeline_helper_;
+    BufferHandle shadow_uniform_buffer_;
+    void *shadow_uniform_location_ = nullptr;
+
+    [[nodiscard]] VkFormat FindShadowFormat() const;
+    void CreateShadowResources();
+    void CreateShadowMap(ShadowMap &shadow_map, std::uint32_t size, std::uint32_t layers);
+    void DestroyShadowMap(ShadowMap &shadow_map) const;
+    void DestroyShadowResources();
+    /// Fits the shadow views to the camera and uploads their matrices.
+    void UpdateShadows();
+    /// Imports the map into the frame graph and, if any of views is dirty, adds
+    /// the pass re-rendering it.
+    RenderGraphResource AddShadowPass(RenderGraph &graph, const std::string &name, const ShadowMap &shadow_map,
+                                      std::span<const ShadowView> views);
+    /// Re-renders the dirty ones of views, which are the map's layers in order.
+    void RecordShadowMap(const ShadowMap &shadow_map, std::span<const ShadowView> views);
 
     Skybox skybox_{};
 
     void CreateSkyboxPipeline();
     void CreateSkyboxDescriptorSetLayout();
     void CreateSkyboxImage(const std::array<const char *, 6> &cubemap_paths);
-    void RenderSkybox();
-    std::vector<glm::vec3> CreateSkyboxVertices();
-    std::vector<uint32_t> CreateSkyboxIndices();
+    void RenderSkybox(VkCommandBuffer command_buffer);
 
     VkFormat FindDepthFormat() const;
     bool HasStencilComponent(VkFormat format) const;
 
     void CreatePostProcessingResources();
     void CreatePostProcessingPipeline();
+    PostEffect &BuildPostEffect(const std::string &fragment_shader_path);
+    PostEffect &BuildComputePostEffect(const std::string &compute_shader_path);
+    void CreateComputePipeline(PipelineHelper &pipeline_helper);
+    bool SetPostChain(const std::vector<PostEffectStep> &chain);
+    void UpdatePostEffects();
     void CreatePostProcessingRenderPass();
+    void CreatePostChainRenderPass();
     void CreatePostProcessingFramebuffer();
     void CreatePostProcessingDescriptorSet();
+    VkDescriptorSet CreatePostDescriptorSet(VkDescriptorPool pool, VkImageView view) const;
+    void CreatePostTarget(PostTarget &target, VkExtent2D extent);
+    void DestroyPostTarget(PostTarget &target) const;
+    void CreatePostProcessingTargets();
+    /// Frees the targets and the compute graph. The device must be idle first.
+    void DestroyPostProcessingTargets();
+    /// Draws one pass into a chain target or, with present set, the swapchain image.
+    void RecordPostPass(VkCommandBuffer command_buffer, const PostPass &pass, VkDescriptorSet source,
+                        VkExtent2D source_extent, const PostTarget &target, bool present) const;
+    [[nodiscard]] PostTarget GetSwapchainTarget() const;
+    /// Rebuilds the compute graph; only after the frame fence, when no frame can still use the old one.
+    void BuildComputePostGraph();
+    /// Frees the graph's memory, views and descriptor pool. Callers wait for the GPU first.
+    void DestroyComputePostGraph();
+    void RecordComputePostPass(VkCommandBuffer command_buffer, const PostPass &pass, const PostTarget &source,
+                               const PostTarget &target, VkDescriptorSet bloom) const;
+    /// Frees everything post-processing owns. The device must be idle first.
     void DestroyPostProcessingResources();
 
     PostProcessing post_processing_{};
+
+    void CreateTimestampQueries();
+    void DestroyTimestampQueries();
+    void CollectTimestamps();
+    /// Writes into vk_command_buffer_ unless another graphics command buffer is given.
+    void WriteTimestamp(GpuScope scope, bool end, VkCommandBuffer command_buffer = VK_NULL_HANDLE) const;
+
+    GpuTimestamps gpu_timestamps_{};
 };
@@ -9,25 +9,8 @@ layout (location = 0) in vec3 input_position;
 layout (location = 1) in vec3 normal;
 layout (location = 2) in vec2 input_uv;
 
-layout (location = 0) out vec2 vertex_uv;
-layout (location = 1) out vec3 oNormal;
-layout (location = 2) out vec3 FragPos;
-layout (location = 3) out vec3 viewPos;
-
-layout (push_constant) uniform Model {
-    mat4 transformation;
-} model;
-
-void main() {
-    vertex_uv = input_uv;
-    // Transform normal by the inverse transpose of the model matrix to handle non-uniform scaling
-    mat3 normalMatrix = transpose(inverse(mat3(model.transformation)));
-    oNormal = normalize(normalMatrix * normal);
-    
-    vec4 vVertex1 = vec4(input_position.x, input_position.y, input_position.z, 1);
-    FragPos = vec3(model.transformation * vVertex1);
-
-    viewPos = camera.viewPos;
-
-    gl_Position = camera.projection * camera.view * model.transformation * vVertex1;
+vec3 DecodeNormal() {
+    return normal;
 }
+
+#include "basic_vertex.glsl"
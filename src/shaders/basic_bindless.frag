@@ -0,0 +1,20 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#include "common.glsl"
+
+// Every texture lives in one table; the draw pushes the index of its own.
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+
+layout(push_constant) uniform Material {
+    layout(offset = 112) uint texture_index;
+} material;
+
+vec3 SampleBaseColor(vec2 uv) {
+    return vec3(texture(textures[material.texture_index], uv));
+}
+
+#include "basic_lighting.glsl"
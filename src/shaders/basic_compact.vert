@@ -0,0 +1,23 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#version 450
+#include "common.glsl"
+
+// oCompactVertex. Positions are unorm16 within the mesh bounds, which the
+// pushed model matrix maps back; uvs arrive as half floats.
+layout (location = 0) in vec3 input_position;
+layout (location = 1) in vec2 octahedral_normal;
+layout (location = 2) in vec2 input_uv;
+
+// Unfolds the octahedron the CPU flattened the unit normal onto.
+vec3 DecodeNormal() {
+    vec3 n = vec3(octahedral_normal, 1.0 - abs(octahedral_normal.x) - abs(octahedral_normal.y));
+    float fold = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -fold : fold;
+    n.y += n.y >= 0.0 ? -fold : fold;
+    return n;
+}
+
+#include "basic_vertex.glsl"
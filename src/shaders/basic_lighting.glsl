@@ -0,0 +1,149 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+// Lighting of the main pass. The including shader declares its textures and
+// defines SampleBaseColor before including this.
+
+layout (location = 0) in vec2 vertex_uv;
+layout (location = 1) in vec3 normal;
+layout (location = 2) in vec3 FragPos;
+layout (location = 3) in vec3 viewPos;
+
+layout (location = 0) out vec4 out_color;
+
+layout(set = 1, binding = 0) uniform UniformBufferObject {
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+    float shininess;
+} ubo;
+
+struct LightUBO{
+    vec4 position; // w: range
+    vec4 diffuse;
+};
+
+layout(std430, set = 3, binding = 0) readonly buffer Lights {
+    LightUBO lights[];
+};
+
+// Froxel grid built on the CPU, see LightClusters.h. Each cluster holds an
+// offset into light_indices and a light count.
+layout(std430, set = 3, binding = 1) readonly buffer ClusterGrid {
+    uvec4 dims;    // tiles x, tiles y, depth slices, light count
+    vec4 slicing;  // slice scale, slice bias, tile size in pixels
+    uvec2 ranges[];
+} clusters;
+
+layout(std430, set = 3, binding = 2) readonly buffer LightIndices {
+    uint light_indices[];
+};
+
+// Cached shadow maps, see ShadowMaps.h. Point lights with a shadow slot in
+// diffuse.w own SHADOW_FACES layers of point_shadow_map.
+#define SHADOW_CASCADES 4
+#define SHADOW_FACES 6
+#define SHADOWED_POINT_LIGHTS 4
+
+layout(std140, set = 3, binding = 3) uniform ShadowData {
+    mat4 cascade_view_proj[SHADOW_CASCADES];
+    mat4 point_view_proj[SHADOWED_POINT_LIGHTS * SHADOW_FACES];
+    vec4 cascade_far;
+    vec4 sun_direction; // w: 1 when there is a sun
+    vec4 sun_diffuse;
+} shadows;
+
+layout(set = 3, binding = 4) uniform sampler2DArrayShadow cascade_shadow_map;
+layout(set = 3, binding = 5) uniform sampler2DArrayShadow point_shadow_map;
+
+float ViewDepth() {
+    return -(camera.view * vec4(FragPos, 1.0)).z;
+}
+
+// 3x3 PCF; each tap is itself a bilinear 2x2 comparison.
+float SampleShadow(sampler2DArrayShadow shadow_map, mat4 view_proj, float layer) {
+    // Pushing the lookup out along the normal keeps surfaces from shadowing themselves
+    vec4 clip = view_proj * vec4(FragPos + normalize(normal) * 0.02, 1.0);
+    vec3 ndc = clip.xyz / clip.w;
+    vec2 uv = ndc.xy * 0.5 + 0.5;
+    vec2 texel = 1.0 / vec2(textureSize(shadow_map, 0).xy);
+
+    float lit = 0.0;
+    for (int y = -1; y <= 1; y++) {
+        for (int x = -1; x <= 1; x++) {
+            lit += texture(shadow_map, vec4(uv + vec2(x, y) * texel, layer, ndc.z));
+        }
+    }
+    return lit / 9.0;
+}
+
+float PointShadow(LightUBO light) {
+    if (light.diffuse.w < 0.0) return 1.0;
+
+    // Face order matches ShadowCache: +X, -X, +Y, -Y, +Z, -Z
+    vec3 toFrag = FragPos - vec3(light.position);
+    vec3 extent = abs(toFrag);
+    uint face = extent.x >= extent.y && extent.x >= extent.z ? (toFrag.x > 0.0 ? 0u : 1u)
+              : extent.y >= extent.z ? (toFrag.y > 0.0 ? 2u : 3u)
+              : (toFrag.z > 0.0 ? 4u : 5u);
+    uint layer = uint(light.diffuse.w) * SHADOW_FACES + face;
+    return SampleShadow(point_shadow_map, shadows.point_view_proj[layer], float(layer));
+}
+
+vec3 CalcSunLight(vec3 texColor) {
+    if (shadows.sun_direction.w == 0.0) return vec3(0.0);
+
+    float diff = max(dot(normalize(normal), -vec3(shadows.sun_direction)), 0.0);
+
+    // First cascade reaching this far; past the last one there is no shadow
+    float depth = ViewDepth();
+    float lit = 1.0;
+    for (int i = 0; i < SHADOW_CASCADES; i++) {
+        if (depth < shadows.cascade_far[i]) {
+            lit = SampleShadow(cascade_shadow_map, shadows.cascade_view_proj[i], float(i));
+            break;
+        }
+    }
+    return vec3(shadows.sun_diffuse) * texColor * diff * lit;
+}
+
+vec4 CalcPointLight(LightUBO light, vec3 texColor)
+{
+    vec3 norm = normalize(normal);
+    vec3 toLight = vec3(light.position) - FragPos;
+    vec3 lightDir = normalize(toLight);
+    
+    // Simple diffuse lighting
+    float diff = max(dot(norm, lightDir), 0.0);
+
+    // Fades out towards the range so lights outside a cluster add nothing
+    float window = clamp(1.0 - pow(length(toLight) / light.position.w, 4.0), 0.0, 1.0);
+    
+    // Combine light color with texture and diffuse factor
+    vec3 result = vec3(light.diffuse) * texColor * diff * window * window * PointShadow(light);
+    
+    return vec4(result, 1.0);
+}
+
+uint ClusterIndex() {
+    uint slice = uint(clamp(floor(log(ViewDepth()) * clusters.slicing.x + clusters.slicing.y), 0.0,
+                            float(clusters.dims.z - 1)));
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.slicing.zw), clusters.dims.xy - 1);
+    return tile.x + clusters.dims.x * (tile.y + clusters.dims.y * slice);
+}
+
+void main() {
+    // Start with base ambient lighting
+    vec3 texColor = SampleBaseColor(vertex_uv);
+    vec4 result = vec4(texColor * 0.2 + CalcSunLight(texColor), 1.0);  // 0.2 is ambient intensity
+    
+    // Add contribution from each light reaching this cluster
+    uvec2 range = clusters.ranges[ClusterIndex()];
+    for (uint i = 0; i < range.y; i++) {
+        result += CalcPointLight(lights[light_indices[range.x + i]], texColor);
+    }
+    
+    // Ensure we don't exceed maximum brightness
+    out_color = clamp(result, 0.0, 1.0);
+}
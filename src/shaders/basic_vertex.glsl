@@ -0,0 +1,34 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+// Shared by basic.vert and basic_compact.vert, which declare the vertex
+// inputs and DecodeNormal for their layout.
+
+layout (location = 0) out vec2 vertex_uv;
+layout (location = 1) out vec3 oNormal;
+layout (location = 2) out vec3 FragPos;
+layout (location = 3) out vec3 viewPos;
+
+layout (push_constant) uniform Model {
+    mat4 transformation;
+    // Inverse transpose of the model matrix, worked out once per draw on the CPU
+    mat3 normal_matrix;
+} model;
+
+// The depth pre-pass runs this shader without the fragment stage; the color
+// pass tests EQUAL against its depth, so both must compute the same position.
+invariant gl_Position;
+
+void main() {
+    vertex_uv = input_uv;
+    // The normal matrix handles non-uniform scaling
+    oNormal = normalize(model.normal_matrix * DecodeNormal());
+    
+    vec4 vVertex1 = vec4(input_position.x, input_position.y, input_position.z, 1);
+    FragPos = vec3(model.transformation * vVertex1);
+
+    viewPos = camera.viewPos;
+
+    gl_Position = camera.projection * camera.view * model.transformation * vVertex1;
+}
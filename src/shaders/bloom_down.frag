@@ -0,0 +1,32 @@
+#version 450
+#include "post_common.glsl"
+
+// Dual-Kawase downsample into a target half the size of the input.
+// head.x: brightness threshold, head.y: 1 on the first level, which also
+// keeps only the bright areas of the image.
+
+float getLuminance(vec3 color) {
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+vec3 getBrightAreas(vec3 color) {
+    float threshold = post.head.x;
+    return color * smoothstep(threshold - 0.1, threshold + 0.1, getLuminance(color));
+}
+
+vec3 fetch(vec2 uv) {
+    vec3 color = texture(screenTexture, uv).rgb;
+    return post.head.y > 0.0 ? getBrightAreas(color) : color;
+}
+
+void main() {
+    // Diagonal taps land between input texels, so each bilinear fetch
+    // averages four of them.
+    vec2 offset = post.texelSize;
+    vec3 sum = fetch(fragTexCoord) * 4.0;
+    sum += fetch(fragTexCoord - offset);
+    sum += fetch(fragTexCoord + offset);
+    sum += fetch(fragTexCoord + vec2(offset.x, -offset.y));
+    sum += fetch(fragTexCoord - vec2(offset.x, -offset.y));
+    outColor = vec4(sum / 8.0, 1.0);
+}
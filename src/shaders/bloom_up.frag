@@ -0,0 +1,18 @@
+#version 450
+#include "post_common.glsl"
+
+// Dual-Kawase upsample of the lowest pyramid level: a tent of eight
+// bilinear taps around the pixel.
+
+void main() {
+    vec2 offset = post.texelSize;
+    vec3 sum = texture(screenTexture, fragTexCoord + vec2(-offset.x, 0.0)).rgb;
+    sum += texture(screenTexture, fragTexCoord + vec2(offset.x, 0.0)).rgb;
+    sum += texture(screenTexture, fragTexCoord + vec2(0.0, -offset.y)).rgb;
+    sum += texture(screenTexture, fragTexCoord + vec2(0.0, offset.y)).rgb;
+    sum += texture(screenTexture, fragTexCoord + vec2(-offset.x, -offset.y) * 0.5).rgb * 2.0;
+    sum += texture(screenTexture, fragTexCoord + vec2(offset.x, -offset.y) * 0.5).rgb * 2.0;
+    sum += texture(screenTexture, fragTexCoord + vec2(-offset.x, offset.y) * 0.5).rgb * 2.0;
+    sum += texture(screenTexture, fragTexCoord + vec2(offset.x, offset.y) * 0.5).rgb * 2.0;
+    outColor = vec4(sum / 12.0, 1.0);
+}
@@ -1,13 +1,13 @@
 #version 450
-layout(location = 0) in vec2 fragTexCoord;
-layout(location = 0) out vec4 outColor;
-layout(binding = 0) uniform sampler2D screenTexture;
 
-float aberration = 0.005;
-vec3 col;
+#include "post_common.glsl"
+
+// head.x: aberration offset, head.y: glow amount
 
 // RGB split for chromatic aberration
 vec3 rgbSplit(sampler2D tex, vec2 uv) {
+    float aberration = post.head.x;
+    vec3 col;
     col.r = texture(tex, vec2(uv.x + aberration, uv.y)).r;
     col.g = texture(tex, uv).g;
     col.b = texture(tex, vec2(uv.x - aberration, uv.y)).b;
@@ -15,6 +15,9 @@ vec3 rgbSplit(sampler2D tex, vec2 uv) {
 }
 
 void main() {
-    vec3 color = rgbSplit(screenTexture, fragTexCoord);
-    outColor = vec4(color, 1.0);
-}
\ No newline at end of file
+    outColor = applyOps(vec4(rgbSplit(screenTexture, fragTexCoord), 1.0), fragTexCoord);
+    // The glow goes on after the fused ops, so they do not scale it.
+    if (post.head.y > 0.0) {
+        outColor.rgb += rgbSplit(screenTexture, fragTexCoord + vec2(0.002)) * post.head.y;
+    }
+}
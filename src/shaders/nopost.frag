@@ -1,10 +1,7 @@
 #version 450
 
-layout(location = 0) in vec2 fragTexCoord;
-layout(location = 0) out vec4 outColor;
-
-layout(binding = 0) uniform sampler2D screenTexture;
+#include "post_common.glsl"
 
 void main() {
-    outColor = texture(screenTexture, fragTexCoord);
-} 
\ No newline at end of file
+    outColor = applyOps(texture(screenTexture, fragTexCoord), fragTexCoord);
+}
@@ -0,0 +1,14 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+// Shared by every post-processing head shader. The head decides how the
+// input is sampled; the pointwise ops fused into the same pass are then
+// applied to its result in order.
+
+#include "post_ops.glsl"
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 0) out vec4 outColor;
+
+layout(set = 0, binding = 0) uniform sampler2D screenTexture;
@@ -0,0 +1,24 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+// Shared by every compute post shader. Set 0 is the sampled input, set 1
+// the storage image the pass writes; the bloom composite adds set 2.
+
+#include "post_ops.glsl"
+
+#define GROUP_SIZE 8
+
+layout(local_size_x = GROUP_SIZE, local_size_y = GROUP_SIZE) in;
+
+layout(set = 0, binding = 0) uniform sampler2D screenTexture;
+layout(set = 1, binding = 0, rgba16f) uniform writeonly image2D outputImage;
+
+bool isOutside(ivec2 pixel) {
+    return any(greaterThanEqual(pixel, imageSize(outputImage)));
+}
+
+// Same coordinates the fragment path gets from post.vert.
+vec2 outputUv(ivec2 pixel) {
+    return (vec2(pixel) + 0.5) / vec2(imageSize(outputImage));
+}
@@ -0,0 +1,58 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+// Push constants and pointwise ops shared by the fragment and compute post
+// paths. Layout matches PostPassConstants.
+
+#define OP_GRAYSCALE 0
+#define OP_COLOR_REDUCTION 1
+#define OP_SCANLINES 2
+#define OP_VIGNETTE 3
+#define OP_BRIGHTNESS 4
+#define MAX_FUSED_OPS 4
+
+layout(push_constant) uniform PostParams {
+    vec4 head;
+    ivec4 ops;
+    vec4 opParams[MAX_FUSED_OPS];
+    vec2 texelSize;
+    int opCount;
+} post;
+
+vec4 applyOp(int op, vec4 params, vec4 color, vec2 uv) {
+    switch (op) {
+        case OP_GRAYSCALE: {
+            float gray = dot(color.rgb, vec3(0.299, 0.587, 0.114));
+            return vec4(gray, gray, gray, color.a);
+        }
+        case OP_COLOR_REDUCTION: {
+            // x: reduction index, 2^x levels per channel
+            float levels = exp2(params.x);
+            color.rgb = floor(color.rgb * levels) / levels;
+            return color;
+        }
+        case OP_SCANLINES: {
+            // x: intensity, y: line frequency
+            float scanline = sin(uv.y * params.y) * params.x + (1.0 - params.x);
+            color.rgb *= scanline;
+            return color;
+        }
+        case OP_VIGNETTE: {
+            // x: strength
+            vec2 centered = uv * 2.0 - 1.0;
+            return color * (1.0 - dot(centered, centered) * params.x);
+        }
+        case OP_BRIGHTNESS:
+            // x: multiplier
+            return color * params.x;
+    }
+    return color;
+}
+
+vec4 applyOps(vec4 color, vec2 uv) {
+    for (int i = 0; i < post.opCount; i++) {
+        color = applyOp(post.ops[i], post.opParams[i], color, uv);
+    }
+    return color;
+}
@@ -0,0 +1,18 @@
+//
+// Created by andre on 18/10/2026.
+//
+
+#version 450
+
+// Depth-only pass into one shadow map layer.
+
+layout (location = 0) in vec3 input_position;
+
+layout (push_constant) uniform ShadowConstants {
+    mat4 transformation;
+    mat4 light_view_projection;
+} constants;
+
+void main() {
+    gl_Position = constants.light_view_projection * constants.transformation * vec4(input_position, 1.0);
+}
@@ -1,21 +1,21 @@
 #version 450
 
-layout(location = 0) in vec3 inPosition;
+// One triangle covering the screen at the far plane; each pixel looks up the
+// cubemap along its view direction.
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 view;
-    mat4 proj;
-} ubo;
+layout(push_constant) uniform SkyboxConstants {
+    // Inverse of projection * camera rotation; translation is left out so the
+    // skybox stays centered on the camera
+    mat4 inverse_view_projection;
+} constants;
 
 layout(location = 0) out vec3 texCoord;
 
 void main() {
-    texCoord = inPosition;
+    vec2 ndc = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2) * 2.0 - 1.0;
+    vec4 direction = constants.inverse_view_projection * vec4(ndc, 1.0, 1.0);
+    texCoord = direction.xyz / direction.w;
 
-    // Remove translation from view matrix to keep skybox centered on camera
-    mat4 viewNoTranslation = mat4(mat3(ubo.view));
-    vec4 pos = ubo.proj * viewNoTranslation * vec4(inPosition, 1.0);
-    
-    // Ensure skybox is always at maximum depth
-    gl_Position = pos.xyww;
-} 
\ No newline at end of file
+    // Depth 1 exactly, so only pixels no opaque covered pass the depth test
+    gl_Position = vec4(ndc, 1.0, 1.0);
+}
@@ -4,41 +4,140 @@
 
 #include <window/Timer.h>
 
+#include <thread>
+
 Timer::Timer() {
-    prevTicks = 0;
-    currTicks = 0;
+    startTicks = Clock::now();
+    prevTicks = startTicks;
+    currTicks = startTicks;
+    nextDeadline = startTicks;
 }
 
 Timer::~Timer() = default;
 
 void Timer::UpdateFrameTicks() {
     prevTicks = currTicks;
-    currTicks = static_cast<unsigned int>(glfwGetTime() * 1000);
+    currTicks = Clock::now();
+
+    frameHistory[historyHead] = (currTicks - prevTicks).count();
+    historyHead = (historyHead + 1) % kHistorySize;
+    historyCount = std::min(historyCount + 1, kHistorySize);
 }
 
 void Timer::Start() {
-    prevTicks = static_cast<unsigned int>(glfwGetTime() * 1000);
-    currTicks = static_cast<unsigned int>(glfwGetTime() * 1000);
+    startTicks = Clock::now();
+    prevTicks = startTicks;
+    currTicks = startTicks;
+    nextDeadline = startTicks + framePeriod;
+    historyHead = 0;
+    historyCount = 0;
 }
 
 float Timer::GetDeltaTime() const {
-    return static_cast<float>(currTicks - prevTicks) / 1000.0f;
+    return std::chrono::duration<float>(currTicks - prevTicks).count();
 }
 
 unsigned int Timer::GetSleepTime(const unsigned int fps) const {
-    const unsigned int milliSecsPerFrame = 1000 / fps;
-    if (milliSecsPerFrame == 0) {
+    if (fps == 0) {
         return 0;
     }
 
-    const unsigned int sleepTime = milliSecsPerFrame - (static_cast<unsigned int>(glfwGetTime() * 1000) - currTicks);
-    if (sleepTime > milliSecsPerFrame) {
-        return milliSecsPerFrame;
+    const auto period = std::chrono::nanoseconds(1'000'000'000 / fps);
+    const auto elapsed = Clock::now() - currTicks;
+    if (elapsed >= period) {
+        return 0;
     }
 
-    return sleepTime;
+    return static_cast<unsigned int>(std::chrono::duration_cast<std::chrono::milliseconds>(period - elapsed).count());
 }
 
 float Timer::GetCurrentTicks() const {
-    return static_cast<float>(currTicks) / 1000.0f;
+    return std::chrono::duration<float>(currTicks - startTicks).count();
+}
+
+FrameStatistics Timer::GetFrameStatistics() const {
+    FrameStatistics stats;
+    if (historyCount == 0) {
+        return stats;
+    }
+
+    std::array<std::int64_t, kHistorySize> sorted{};
+    std::copy_n(frameHistory.begin(), historyCount, sorted.begin());
+    const auto end = sorted.begin() + static_cast<std::ptrdiff_t>(historyCount);
+    std::sort(sorted.begin(), end);
+
+    std::int64_t total = 0;
+    for (auto it = sorted.begin(); it != end; ++it) total += *it;
+
+    const std::size_t p99_index = std::min(historyCount - 1, (historyCount * 99) / 100);
+
+    stats.min_ms = static_cast<double>(sorted[0]) / 1.0e6;
+    stats.max_ms = static_cast<double>(sorted[historyCount - 1]) / 1.0e6;
+    stats.p99_ms = static_cast<double>(sorted[p99_index]) / 1.0e6;
+    stats.avg_ms = static_cast<double>(total) / static_cast<double>(historyCount) / 1.0e6;
+    stats.samples = historyCount;
+    return stats;
+}
+
+void Timer::SetTargetFrameRate(const double fps) {
+    if (fps <= 0.0) {
+        framePeriod = std::chrono::nanoseconds(0);
+        return;
+    }
+    framePeriod = std::chrono::nanoseconds(static_cast<std::int64_t>(1.0e9 / fps));
+    nextDeadline = Clock::now() + framePeriod;
+}
+
+double Timer::GetTargetFrameRate() const {
+    if (framePeriod.count() == 0) return 0.0;
+    return 1.0e9 / static_cast<double>(framePeriod.count());
+}
+
+void Timer::MarkPresent(const Clock::time_point presentReturned) {
+    if (framePeriod.count() == 0) return;
+
+    // Only pull the schedule towards the present call when it has drifted by
+    // more than a quarter frame; small corrections every frame would just add jitter.
+    const auto drift = (presentReturned + framePeriod) - nextDeadline;
+    if (std::chrono::abs(drift) > framePeriod / 4) {
+        nextDeadline = presentReturned + framePeriod;
+    }
+}
+
+void Timer::WaitForNextFrame() {
+    if (framePeriod.count() == 0) return;
+
+    const Clock::time_point now = Clock::now();
+    if (now >= nextDeadline) {
+        // Missed the deadline: skip ahead instead of trying to catch up with a
+        // burst of short frames.
+        nextDeadline = now + framePeriod;
+        return;
+    }
+
+    SleepUntil(nextDeadline);
+    nextDeadline += framePeriod;
+}
+
+void Timer::SleepUntil(const Clock::time_point deadline) {
+    using namespace std::chrono;
+
+    auto remaining = static_cast<double>(duration_cast<nanoseconds>(deadline - Clock::now()).count());
+    while (remaining > sleepEstimateNs) {
+        const auto begin = Clock::now();
+        std::this_thread::sleep_for(milliseconds(1));
+        const auto observed = static_cast<double>(duration_cast<nanoseconds>(Clock::now() - begin).count());
+        remaining -= observed;
+
+        ++sleepSamples;
+        const double delta = observed - sleepMeanNs;
+        sleepMeanNs += delta / static_cast<double>(sleepSamples);
+        sleepM2 += delta * (observed - sleepMeanNs);
+        const double stddev = std::sqrt(sleepM2 / static_cast<double>(sleepSamples - 1));
+        sleepEstimateNs = sleepMeanNs + stddev;
+    }
+
+    while (Clock::now() < deadline) {
+        std::this_thread::yield();
+    }
 }
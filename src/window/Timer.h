@@ -5,8 +5,21 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include <array>
+#include <chrono>
+
+struct FrameStatistics {
+    double min_ms = 0.0;
+    double avg_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+    std::size_t samples = 0;
+};
+
 class Timer {
 public:
+    using Clock = std::chrono::steady_clock;
+
     Timer();
     ~Timer();
 
@@ -20,10 +33,48 @@ public:
     [[nodiscard]] float GetDeltaTime() const;
     [[nodiscard]] unsigned int GetSleepTime(unsigned int fps) const;
     [[nodiscard]] float GetCurrentTicks() const;
+
+    [[nodiscard]] std::chrono::nanoseconds GetFrameTime() const { return currTicks - prevTicks; }
+    [[nodiscard]] FrameStatistics GetFrameStatistics() const;
+
+    /// 0 disables the limiter. Frames are paced against absolute deadlines so
+    /// sleep jitter on one frame does not push every following frame back.
+    void SetTargetFrameRate(double fps);
+    [[nodiscard]] double GetTargetFrameRate() const;
+
+    /// Re-anchors the pacing schedule on the moment the present call for a
+    /// frame returned. That is when the image was queued, not when it reached
+    /// the display, so this only keeps the limiter from drifting against the
+    /// swapchain's own blocking.
+    void MarkPresent(Clock::time_point presentReturned = Clock::now());
+
+    /// Blocks until the next frame deadline. Coarse OS sleeps cover most of
+    /// the wait and only the last stretch (sized from observed oversleep) is
+    /// spent yielding in a loop.
+    void WaitForNextFrame();
+
 private:
-    unsigned int prevTicks;
-    unsigned int currTicks;
+    static constexpr std::size_t kHistorySize = 512;
+
+    void SleepUntil(Clock::time_point deadline);
+
+    Clock::time_point startTicks;
+    Clock::time_point prevTicks;
+    Clock::time_point currTicks;
+
+    std::chrono::nanoseconds framePeriod{0};
+    Clock::time_point nextDeadline;
+
+    // Running estimate of how far past the requested duration a 1 ms sleep
+    // actually returns; used to decide when to stop sleeping and start spinning.
+    double sleepEstimateNs = 2'000'000.0;
+    double sleepMeanNs = 1'000'000.0;
+    double sleepM2 = 0.0;
+    std::uint64_t sleepSamples = 1;
+
+    std::array<std::int64_t, kHistorySize> frameHistory{};
+    std::size_t historyHead = 0;
+    std::size_t historyCount = 0;
 };
 
 #endif
-
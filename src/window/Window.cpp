@@ -39,6 +39,17 @@ glm::ivec2 Window::GetFrameBufferSize() const {
     return {real_width, real_height};
 }
 
+int Window::GetRefreshRate() const {
+    GLFWmonitor *monitor = glfwGetWindowMonitor(window);
+    if (monitor == nullptr)
+        monitor = glfwGetPrimaryMonitor();
+    if (monitor == nullptr)
+        return 0;
+
+    const GLFWvidmode *mode = glfwGetVideoMode(monitor);
+    return mode != nullptr ? mode->refreshRate : 0;
+}
+
 void Window::processInput(GLFWwindow *window) {
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
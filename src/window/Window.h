@@ -12,6 +12,7 @@ public:
     ~Window();
     [[nodiscard]] GLFWwindow *getGLFWwindow() const {return window;}
     [[nodiscard]] glm::ivec2 GetFrameBufferSize() const;;
+    [[nodiscard]] int GetRefreshRate() const;
     static void processInput(GLFWwindow *window);
     GLFWwindow *GetWindow();
 private: